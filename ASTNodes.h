@@ -1,590 +1,2356 @@
-#pragma once
-#include <vector>
-#include <string>
-#include <memory>
-#include "parser.h"
-
-using namespace std;
-
-//---GLOBALS---
-//Token Types
-enum class TokenType
-{
-	DEF, RETURN, PRINT, CALL_METHOD,
-	INT, FLOAT, STRING, BOOL, LIST, TUPLE, DICT,
-	AND, OR, NOT, TRUE, FALSE,
-	IF, ELIF, ELSE, FOR, WHILE, IN, RANGE, MATCH, CASE,
-	IDENTIFIER, NUMBER, FLOATING, STRING_LITERAL,
-	FSTRING_START, FSTRING_END, FSTRING_EXPR_START, FSTRING_EXPR_END, FSTRING_FORMAT_SPEC, ALIGNMENT,
-	COLON, COMMA, SEP, DOT, LEN,
-	EQUALS, EQ, NOTEQ, GREATER, LESSER, GREATEREQ, LESSEREQ,
-	PLUS, MINUS, MULT, DIV,
-	LPAREN, RPAREN, LBRACKET, RBRACKET, LBRACE, RBRACE,
-	INDENT, DEDENT,
-	NEWLINE, EOF_TOKEN
-};
-
-//Token Structure
-struct Token
-{
-	TokenType type;
-	string value;
-	int line;
-};
-
-//Variable Type
-enum class VarType
-{
-	INT, FLOAT, STRING, BOOL, LIST, TUPLE, DICT, NONE
-};
-
-//Collection Type
-struct CollectionType
-{
-	VarType base_type;
-	VarType element_type;
-	VarType key_type;
-	VarType value_type;
-};
-
-//---ABSTRACT SYNTAX TREE---
-//Abstract Syntax Tree
-struct ASTNode
-{
-	virtual string generate_c_code(vector<string>& gc_strings) const = 0;
-	virtual ~ASTNode() = default;
-};
-
-//Helper Code Node
-struct HelperNode : public ASTNode
-{
-	string code;
-
-	HelperNode(const string& c) : code(c) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		return code;
-	}
-};
-
-struct AssignNode : public ASTNode
-{
-	string var;
-	string expr;
-	CollectionType type;
-	bool is_declaration;
-
-	AssignNode(const string& v, const string& e, CollectionType t, bool decl) : var(v), expr(e), type(t), is_declaration(decl) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code;
-		string c_type;
-
-		if (type.base_type == VarType::INT)
-			c_type = "int";
-		else if (type.base_type == VarType::FLOAT)
-			c_type = "float";
-		else if (type.base_type == VarType::STRING)
-		{
-			c_type = "char*";
-			gc_strings.push_back(var);
-		}
-		else if (type.base_type == VarType::BOOL)
-			c_type = "int";							//BOOL as INT (?)
-		else if (type.base_type == VarType::LIST)
-		{
-			c_type = "List" + Parser::vartype_to_c(type.element_type) + "*";
-			gc_strings.push_back(var);
-		}
-		else if (type.base_type == VarType::TUPLE)
-		{
-			c_type = "Tuple" + Parser::vartype_to_c(type.element_type) + "*";
-			gc_strings.push_back(var);
-		}
-		else if (type.base_type == VarType::DICT)
-		{
-			c_type = "DictString" + Parser::vartype_to_c(type.value_type) + "*";
-			gc_strings.push_back(var);
-		}
-
-		if (is_declaration)
-		{
-			if (type.base_type == VarType::STRING)
-			{
-				code += "char* " + var + " = (char*)malloc(strlen(" + expr + ") + 1);\n";
-				code += "    strcpy(" + var + ", " + expr + ");\n";
-			}
-			else if (type.base_type == VarType::LIST)
-				code += c_type + " " + var + " = " + expr + ";\n";
-			else if (type.base_type == VarType::TUPLE)
-				code += c_type + " " + var + " = " + expr + ";\n";
-			else if (type.base_type == VarType::DICT)
-				code += c_type + " " + var + " = " + expr + ";\n";
-			else
-				code += c_type + " " + var + " = " + expr + ";\n";
-		}
-		else
-		{
-			if (type.base_type == VarType::STRING)
-			{
-				code += "free(" + var + ");\n";
-				code += "    " + var + " = (char*)malloc(strlen(" + expr + ") + 1);\n";
-				code += "    strcpy(" + var + ", " + expr + ");\n";
-			}
-			else
-				code += var + " = " + expr + ";\n";
-		}
-
-		return code;
-	}
-};
-
-struct FunctionNode : public ASTNode
-{
-	string name;
-	vector<pair<string, CollectionType>> args;
-	CollectionType return_type;
-	vector<unique_ptr<ASTNode>> body;
-
-	FunctionNode(const string& n, const vector<pair<string, CollectionType>>& a, CollectionType rt) : name(n), args(a), return_type(rt) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code;
-
-		//Function Return Type
-		string return_c_type = return_type.base_type == VarType::NONE ? "void" :
-			return_type.base_type == VarType::INT ? "int" :
-			return_type.base_type == VarType::FLOAT ? "float" :
-			return_type.base_type == VarType::STRING ? "char*" :
-			return_type.base_type == VarType::BOOL ? "int" :
-			return_type.base_type == VarType::LIST ? "List" + Parser::vartype_to_c(return_type.element_type) + "*" :
-			return_type.base_type == VarType::TUPLE ? "Tuple" + Parser::vartype_to_c(return_type.element_type) + "*" :
-			"DictString" + Parser::vartype_to_c(return_type.value_type) + "*";
-
-		code += return_c_type + " " + name + "(";
-
-		//Function Argument Type(s)
-		for (size_t i = 0; i < args.size(); ++i)
-		{
-			const auto& arg = args[i];
-			string arg_type = arg.second.base_type == VarType::INT ? "int" :
-				arg.second.base_type == VarType::FLOAT ? "float" :
-				arg.second.base_type == VarType::STRING ? "char*" :
-				arg.second.base_type == VarType::BOOL ? "int" :
-				arg.second.base_type == VarType::LIST ? "List" + Parser::vartype_to_c(arg.second.element_type) + "*" :
-				arg.second.base_type == VarType::TUPLE ? "Tuple" + Parser::vartype_to_c(arg.second.element_type) + "*" :
-				"DictString" + Parser::vartype_to_c(arg.second.value_type) + "*";
-
-			code += arg_type + " " + arg.first;
-
-			if (arg.second.base_type == VarType::STRING || arg.second.base_type == VarType::LIST ||
-				arg.second.base_type == VarType::TUPLE || arg.second.base_type == VarType::DICT)
-				gc_strings.push_back(arg.first);
-
-			if (i < args.size() - 1)
-				code += ", ";
-		}
-
-		code += ")\n{\n";
-
-		//Function Body
-		for (const auto& node : body)
-			code += "    " + node->generate_c_code(gc_strings) + "\n";
-
-		//Cleanup
-		for (const auto& var : gc_strings)
-		{
-			if (return_type.base_type == VarType::STRING && var == "return_value")
-				continue;
-
-			if (variables.find(var) != variables.end())
-			{
-				CollectionType var_type = variables.at(var);
-
-				if (var_type.base_type == VarType::STRING)
-					code += "    free_string(" + var + ");\n";
-				else if (var_type.base_type == VarType::LIST)
-					code += "    free_list_" + Parser::vartype_to_c(var_type.element_type) + "(" + var + ");\n";
-				else if (var_type.base_type == VarType::TUPLE)
-					code += "    free_tuple_" + Parser::vartype_to_c(var_type.element_type) + "(" + var + ");\n";
-				else if (var_type.base_type == VarType::DICT)
-					code += "    free_dict_string_" + Parser::vartype_to_c(var_type.value_type) + "(" + var + ");\n";
-			}
-		}
-
-		gc_strings.clear();
-		code += "\n}\n";
-
-		return code;
-	}
-
-private:
-	map<string, CollectionType> variables;		//Local variable tracking for cleanup
-};
-
-struct CallNode : public ASTNode
-{
-	string func_name;
-	vector<string> args;
-	CollectionType return_type;
-
-	CallNode(const string& fn, const vector<string>& a, CollectionType rt) : func_name(fn), args(a), return_type(rt) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code;
-
-		if (return_type.base_type == VarType::STRING || return_type.base_type == VarType::LIST ||
-			return_type.base_type == VarType::TUPLE || return_type.base_type == VarType::DICT)
-		{
-			string temp_var = "temp_call_" + to_string(rand());
-			string c_type = return_type.base_type == VarType::STRING ? "char*" :
-				return_type.base_type == VarType::LIST ? "List" + Parser::vartype_to_c(return_type.element_type) + "*" :
-				return_type.base_type == VarType::TUPLE ? "Tuple" + Parser::vartype_to_c(return_type.element_type) + "*" :
-				"DictString" + Parser::vartype_to_c(return_type.value_type) + "*";
-
-			code += c_type + " " + temp_var + " = " + func_name + "(";
-			gc_strings.push_back(temp_var);
-		}
-		else
-			code += func_name + "(";
-
-		for (size_t i = 0; i < args.size(); ++i)
-		{
-			code += args[i];
-
-			if (i < args.size() - 1)
-				code += ", ";
-		}
-
-		code += ");\n";
-
-		return code;
-	}
-};
-
-struct MethodCallNode : public ASTNode
-{
-	string var;
-	string method;
-	vector<string> args;
-	CollectionType return_type;
-
-	MethodCallNode(const string& v, const string& m, const vector<string>& a, CollectionType rt) : var(v), method(m), args(a), return_type(rt) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code;
-		string temp_var = "temp_method_" + to_string(rand());
-
-		if (method == "append")
-			code += "list_append_" + Parser::vartype_to_c(return_type.element_type) + "(" + var + ", " + args[0] + ");\n";
-		else if (method == "upper" || method == "lower" || method == "strip")
-		{
-			code += "char* " + temp_var + " = str_" + method + "(" + var + ");\n";
-			gc_strings.push_back(temp_var);
-		}
-		else if (method == "replace")
-		{
-			code += "char* " + temp_var + " = str_replace(" + var + ", " + args[0] + ", " + args[1] + ");\n";
-			gc_strings.push_back(temp_var);
-		}
-		else if (method == "split")
-		{
-			code += "ListString* " + temp_var + " = str_split(" + var + ", " + (args.empty() ? "NULL" : args[0]) + ");\n";
-			gc_strings.push_back(temp_var);
-		}
-		else if (method == "find")
-			code += "int " + temp_var + " = str_find(" + var + ", " + args[0] + ");\n";
-
-		return code;
-	}
-};
-
-struct ReturnNode : public ASTNode
-{
-	string expr;
-	CollectionType type;
-
-	ReturnNode(const string& e, CollectionType t) : expr(e), type(t) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		if (type.base_type == VarType::STRING || type.base_type == VarType::LIST ||
-			type.base_type == VarType::TUPLE || type.base_type == VarType::DICT)
-			gc_strings.push_back("return_value");
-
-		return "return_value = " + expr + ";\n    return return_value;\n";
-	}
-};
-
-struct PrintNode : public ASTNode
-{
-	vector<pair<string, VarType>> values;
-	string separator;
-
-	PrintNode(const vector<pair<string, VarType>>& vals, const string& sep) : values(vals), separator(sep) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code;
-		string format;
-		string args;
-
-		for (size_t i = 0; i < values.size(); ++i)
-		{
-			const auto& val = values[i];
-
-			if (val.second == VarType::INT)
-				format += "%d";
-			else if (val.second == VarType::FLOAT)
-				format += "%f";
-			else if (val.second == VarType::STRING)
-				format += "%s";
-			else if (val.second == VarType::BOOL)
-			{
-				format += "%s";
-				args += ", " + val.first + " ? \"true\" : \"false\"";
-			}
-			else if (val.second == VarType::LIST)
-			{
-				format += "%s";
-				args += ", list_to_string_" + Parser::vartype_to_c(val.second) + "(" + val.first + ")";
-			}
-			else if (val.second == VarType::TUPLE)
-			{
-				format += "%s";
-				args += ", tuple_to_string_" + Parser::vartype_to_c(val.second) + "(" + val.first + ")";
-			}
-			else if (val.second == VarType::DICT)
-			{
-				format += "%s";
-				args += ", dict_to_string_string_" + Parser::vartype_to_c(val.second) + "(" + val.first + ")";
-			}
-
-			if (i < values.size() - 1)
-				format += separator;
-
-			if (val.second != VarType::BOOL && val.second != VarType::LIST &&
-				val.second != VarType::TUPLE && val.second != VarType::DICT)
-				args += ", " + val.first;
-		}
-
-		format += "\\n";
-		code += "printf(\"" + format + "\"" + args + ");\n";
-
-		return code;
-	}
-};
-
-struct IfNode : public ASTNode
-{
-	string condition;
-	vector<unique_ptr<ASTNode>> body;
-	vector<pair<string, vector<unique_ptr<ASTNode>>>> elif_clauses;
-	vector<unique_ptr<ASTNode>> else_body;
-
-	IfNode(const string& cond) : condition(cond) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code = "if (" + condition + ")\n{\n";
-
-		for (const auto& node : body)
-			code += "    " + node->generate_c_code(gc_strings) + "\n";
-
-		code += "\n}";
-
-		for (const auto& elif : elif_clauses)
-		{
-			code += " else if (" + elif.first + ")\n{\n";
-
-			for (const auto& node : elif.second)
-				code += "    " + node->generate_c_code(gc_strings) + "\n";
-
-			code += "\n}";
-		}
-
-		if (!else_body.empty())
-		{
-			code += " else\n{\n";
-
-			for (const auto& node : else_body)
-				code += "    " + node->generate_c_code(gc_strings) + "\n";
-
-			code += "\n}";
-		}
-
-		code += "\n";
-
-		return code;
-	}
-};
-
-struct ForNode : public ASTNode
-{
-	string var;
-	string start;
-	string end;
-	vector<unique_ptr<ASTNode>> body;
-
-	ForNode(const string& v, const string& s, const string& e) : var(v), start(s), end(e) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code = "for (int " + var + " = " + start + "; " + var + " < " + end + "; " + var + "++)\n{\n";
-
-		for (const auto& node : body)
-			code += "    " + node->generate_c_code(gc_strings) + "\n";
-
-		code += "\n}\n";
-
-		return code;
-	}
-};
-
-struct WhileNode : public ASTNode
-{
-	string condition;
-	vector<unique_ptr<ASTNode>> body;
-
-	WhileNode(const string& cond) : condition(cond) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code = "while (" + condition + ")\n{\n";
-
-		for (const auto& node : body)
-			code += "    " + node->generate_c_code(gc_strings) + "\n";
-
-		code += "\n}\n";
-
-		return code;
-	}
-};
-
-struct MatchNode : public ASTNode
-{
-	string expr;
-	VarType expr_type;
-	vector<pair<string, vector<unique_ptr<ASTNode>>>> cases;
-	vector<unique_ptr<ASTNode>> default_case;
-
-	MatchNode(const string& e, VarType t) : expr(e), expr_type(t) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string code = "switch (" + expr + ")\n{\n";
-
-		for (const auto& c : cases)
-		{
-			code += "    case " + c.first + ":\n";
-
-			for (const auto& node : c.second)
-				code += "        " + node->generate_c_code(gc_strings) + "\n";
-
-			code += "        break;\n";
-		}
-
-		if (!default_case.empty())
-		{
-			code += "    default:\n";
-
-			for (const auto& node : default_case)
-				code += "        " + node->generate_c_code(gc_strings) + "\n";
-
-			code += "        break;\n";
-		}
-
-		code += "\n}\n";
-
-		return code;
-	}
-};
-
-struct ListNode : public ASTNode
-{
-	vector<string> elements;
-	CollectionType type;
-
-	ListNode(const vector<string>& elems, CollectionType t) : elements(elems), type(t) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string temp_var = "temp_list_" + to_string(rand());
-		string code = "List" + Parser::vartype_to_c(type.element_type) + "* " + temp_var +
-			" = create_list_" + Parser::vartype_to_c(type.element_type) + "(" +
-			to_string(elements.size()) + ");\n";
-
-		for (size_t i = 0; i < elements.size(); ++i)
-			code += "    " + temp_var + "->data[" + to_string(i) + "] = " + elements[i] + ";\n";
-
-		gc_strings.push_back(temp_var);
-
-		return code + "    " + temp_var;
-	}
-};
-
-struct TupleNode : public ASTNode
-{
-	vector<string> elements;
-	CollectionType type;
-
-	TupleNode(const vector<string>& elems, CollectionType t) : elements(elems), type(t) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string temp_var = "temp_tuple_" + to_string(rand());
-		string code = "Tuple" + Parser::vartype_to_c(type.element_type) + "* " + temp_var +
-			" = create_tuple_" + Parser::vartype_to_c(type.element_type) + "(" +
-			to_string(elements.size()) + ");\n";
-
-		for (size_t i = 0; i < elements.size(); ++i)
-			code += "    " + temp_var + "->data[" + to_string(i) + "] = " + elements[i] + ";\n";
-
-		gc_strings.push_back(temp_var);
-
-		return code + "    " + temp_var;
-	}
-};
-
-struct DictNode : public ASTNode
-{
-	vector<pair<string, string>> entries;
-	CollectionType type;
-
-	DictNode(const std::vector<std::pair<std::string, std::string>>& e, CollectionType t) : entries(e), type(t) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		string temp_var = "temp_dict_" + to_string(rand());
-		string code = "DictString" + Parser::vartype_to_c(type.value_type) + "* " + temp_var +
-			" = create_dict_string_" + Parser::vartype_to_c(type.value_type) + "();\n";
-
-		for (const auto& entry : entries)
-			code += "    dict_set_string_" + Parser::vartype_to_c(type.value_type) + "(" + temp_var + ", " + entry.first + ", " + entry.second + ");\n";
-
-		gc_strings.push_back(temp_var);
-
-		return code + "    " + temp_var;
-	}
-};
-
-struct LenNode : public ASTNode
-{
-	string expr;
-	CollectionType expr_type;
-
-	LenNode(const string& e, CollectionType t) : expr(e), expr_type(t) {}
-
-	string generate_c_code(vector<string>& gc_strings) const override
-	{
-		if (expr_type.base_type == VarType::STRING)
-			return "strlen(" + expr + ")";
-		else
-			return expr + "->size";
-	}
-};
\ No newline at end of file
+#pragma once
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <map>
+#include <set>
+#include <cstdlib>
+#include <sstream>
+#include "emitter.h"
+#include "arena.h"
+#include "symbols.h"
+
+using namespace std;
+
+//---GLOBALS---
+//Token Types
+enum class TokenType
+{
+	DEF, RETURN, PRINT, CALL_METHOD,
+	INT, FLOAT, STRING, BOOL, LIST, TUPLE, DICT,
+	AND, OR, NOT, TRUE, FALSE,
+	IF, ELIF, ELSE, FOR, WHILE, IN, RANGE, MATCH, CASE,
+	IDENTIFIER, NUMBER, FLOATING, STRING_LITERAL,
+	FSTRING_START, FSTRING_END, FSTRING_EXPR_START, FSTRING_EXPR_END, FSTRING_FORMAT_SPEC, ALIGNMENT,
+	COLON, COMMA, SEP, DOT, LEN,
+	EQUALS, EQ, NOTEQ, GREATER, LESSER, GREATEREQ, LESSEREQ,
+	PLUS, MINUS, MULT, DIV,
+	LPAREN, RPAREN, LBRACKET, RBRACKET, LBRACE, RBRACE,
+	INDENT, DEDENT,
+	NEWLINE, EOF_TOKEN
+};
+
+//Token Structure
+//Values are views into the lexer's source buffer
+struct Token
+{
+	TokenType type;
+	string_view value;
+	int line;
+	uint32_t symbol = SymbolTable::NONE;		//Interned ID, identifiers only
+};
+
+//Variable Type
+enum class VarType
+{
+	INT, FLOAT, STRING, BOOL, LIST, TUPLE, DICT, NONE
+};
+
+//Collection Type
+struct CollectionType
+{
+	VarType base_type = VarType::NONE;
+	VarType element_type = VarType::NONE;
+	VarType key_type = VarType::NONE;
+	VarType value_type = VarType::NONE;
+};
+
+//---TYPE HELPERS---
+inline string vartype_to_c(VarType type)
+{
+	switch (type)
+	{
+	case VarType::INT:
+		return "int";
+	case VarType::FLOAT:
+		return "float";
+	case VarType::STRING:
+		return "string";
+	case VarType::BOOL:
+		return "bool";
+	case VarType::LIST:
+		return "list";
+	case VarType::TUPLE:
+		return "tuple";
+	case VarType::DICT:
+		return "dict";
+	default:
+		return "void";
+	}
+}
+
+//C Declaration Type
+inline string c_type(const CollectionType& type)
+{
+	switch (type.base_type)
+	{
+	case VarType::INT:
+		return "int";
+	case VarType::FLOAT:
+		return "float";
+	case VarType::STRING:
+		return "String";
+	case VarType::BOOL:
+		return "int";								//BOOL as INT (?)
+	case VarType::LIST:
+		return "List" + vartype_to_c(type.element_type) + "*";
+	case VarType::TUPLE:
+		return "Tuple" + vartype_to_c(type.element_type) + "*";
+	case VarType::DICT:
+		return "DictString" + vartype_to_c(type.value_type) + "*";
+	default:
+		return "void";
+	}
+}
+
+inline bool is_heap_type(VarType type)
+{
+	return type == VarType::STRING || type == VarType::LIST || type == VarType::TUPLE || type == VarType::DICT;
+}
+
+//Runtime Call Releasing a Heap Value
+inline string free_c(string_view name, const CollectionType& type)
+{
+	string var(name);
+
+	if (type.base_type == VarType::STRING)
+		return "free_string(" + var + ");";
+	else if (type.base_type == VarType::LIST)
+		return "free_list_" + vartype_to_c(type.element_type) + "(" + var + ");";
+	else if (type.base_type == VarType::TUPLE)
+		return "free_tuple_" + vartype_to_c(type.element_type) + "(" + var + ");";
+	else if (type.base_type == VarType::DICT)
+		return "free_dict_string_" + vartype_to_c(type.value_type) + "(" + var + ");";
+
+	return "";
+}
+
+//Runtime Call Making an Owned Copy of a Heap Value
+inline string copy_c(const string& value, const CollectionType& type)
+{
+	if (type.base_type == VarType::STRING)
+		return "string_copy(" + value + ")";
+	else if (type.base_type == VarType::LIST)
+		return "copy_list_" + vartype_to_c(type.element_type) + "(" + value + ")";
+	else if (type.base_type == VarType::TUPLE)
+		return "copy_tuple_" + vartype_to_c(type.element_type) + "(" + value + ")";
+	else if (type.base_type == VarType::DICT)
+		return "copy_dict_string_" + vartype_to_c(type.value_type) + "(" + value + ")";
+
+	return value;
+}
+
+//Runtime Call Taking a Variable's Heap Value and Leaving It Empty
+inline string move_c(string_view var, const CollectionType& type)
+{
+	string address = "&" + string(var);
+
+	if (type.base_type == VarType::STRING)
+		return "string_move(" + address + ")";
+	else if (type.base_type == VarType::LIST)
+		return "move_list_" + vartype_to_c(type.element_type) + "(" + address + ")";
+	else if (type.base_type == VarType::TUPLE)
+		return "move_tuple_" + vartype_to_c(type.element_type) + "(" + address + ")";
+	else if (type.base_type == VarType::DICT)
+		return "move_dict_string_" + vartype_to_c(type.value_type) + "(" + address + ")";
+
+	return string(var);
+}
+
+//C String for a Value Printed with %s
+inline string to_string_c(const string& value, const CollectionType& type)
+{
+	if (type.base_type == VarType::STRING)
+		return "string_data(" + value + ")";
+	else if (type.base_type == VarType::LIST)
+		return "list_to_string_" + vartype_to_c(type.element_type) + "(" + value + ")";
+	else if (type.base_type == VarType::TUPLE)
+		return "tuple_to_string_" + vartype_to_c(type.element_type) + "(" + value + ")";
+	else if (type.base_type == VarType::DICT)
+		return "dict_to_string_string_" + vartype_to_c(type.value_type) + "(" + value + ")";
+
+	return value;
+}
+
+//Runtime Call for a String / List Method
+inline string method_call_c(string_view name, string_view method, const vector<string>& args, const CollectionType& var_type)
+{
+	string var(name);
+
+	if (method == "append")
+		return "list_append_" + vartype_to_c(var_type.element_type) + "(" + var + ", " + args[0] + ")";
+	else if (method == "upper" || method == "lower" || method == "strip")
+		return "str_" + string(method) + "(" + var + ")";
+	else if (method == "replace")
+		return "str_replace(" + var + ", " + args[0] + ", " + args[1] + ")";
+	else if (method == "split")
+		return args.empty() ? "str_split_whitespace(" + var + ")" : "str_split(" + var + ", " + args[0] + ")";
+	else
+		return "str_find(" + var + ", " + args[0] + ")";
+}
+
+//---RUNTIME FEATURES---
+enum class StringMethod
+{
+	UPPER, LOWER, STRIP, REPLACE, SPLIT, FIND,
+	CONCAT, EQUALS, COMPARE, FORMAT		//Operators and f-strings
+};
+
+inline StringMethod string_method(string_view method)
+{
+	if (method == "upper")
+		return StringMethod::UPPER;
+	else if (method == "lower")
+		return StringMethod::LOWER;
+	else if (method == "strip")
+		return StringMethod::STRIP;
+	else if (method == "replace")
+		return StringMethod::REPLACE;
+	else if (method == "split")
+		return StringMethod::SPLIT;
+	else
+		return StringMethod::FIND;
+}
+
+//Runtime support a program or a single function needs, one bit per element type or method.
+//Plain masks, so a copy can live in an arena node.
+struct RuntimeFeatures
+{
+	uint32_t lists = 0;					//Element types
+	uint32_t tuples = 0;				//Element types
+	uint32_t dicts = 0;					//Value types; keys are always strings
+	uint32_t appended_lists = 0;		//Lists with list_append
+	uint32_t printed_lists = 0;			//Containers converted to text by print or an f-string
+	uint32_t printed_tuples = 0;
+	uint32_t printed_dicts = 0;
+	uint32_t printed_values = 0;		//Types passed straight to print
+	uint32_t string_methods = 0;
+
+	static uint32_t bit(VarType type)
+	{
+		return 1u << (int)type;
+	}
+
+	static uint32_t bit(StringMethod method)
+	{
+		return 1u << (int)method;
+	}
+
+	//Types in a mask, in declaration order
+	static vector<VarType> types(uint32_t mask)
+	{
+		vector<VarType> result;
+
+		for (int type = 0; type <= (int)VarType::NONE; ++type)
+		{
+			if (mask & (1u << type))
+				result.push_back((VarType)type);
+		}
+
+		return result;
+	}
+
+	bool has_method(StringMethod method) const
+	{
+		return (string_methods & bit(method)) != 0;
+	}
+
+	void use(const CollectionType& type)
+	{
+		if (type.base_type == VarType::LIST)
+			lists |= bit(type.element_type);
+		else if (type.base_type == VarType::TUPLE)
+			tuples |= bit(type.element_type);
+		else if (type.base_type == VarType::DICT)
+			dicts |= bit(type.value_type);
+	}
+
+	void use_printed(const CollectionType& type)
+	{
+		use(type);
+
+		if (type.base_type == VarType::LIST)
+			printed_lists |= bit(type.element_type);
+		else if (type.base_type == VarType::TUPLE)
+			printed_tuples |= bit(type.element_type);
+		else if (type.base_type == VarType::DICT)
+			printed_dicts |= bit(type.value_type);
+	}
+
+	void use_print(const CollectionType& type)
+	{
+		use_printed(type);
+		printed_values |= bit(type.base_type);
+	}
+
+	void use_method(string_view method, const CollectionType& var_type)
+	{
+		use(var_type);
+
+		if (method == "append")
+		{
+			appended_lists |= bit(var_type.element_type);
+			return;
+		}
+
+		string_methods |= bit(string_method(method));
+
+		//str_split builds a list of strings
+		if (method == "split")
+		{
+			lists |= bit(VarType::STRING);
+			appended_lists |= bit(VarType::STRING);
+		}
+	}
+};
+
+//---CONSTANT FOLDING---
+//Value of a literal as C evaluates it: a whole number is an int, a decimal a double and an
+//f-suffixed decimal a float. Booleans are ints. Strings keep their source text, escapes and all.
+struct Constant
+{
+	enum class Kind
+	{
+		INT, FLOAT, DOUBLE, TEXT
+	};
+
+	Kind kind = Kind::INT;
+	long long integer = 0;
+	double real = 0;
+	string_view text;
+
+	double number() const
+	{
+		return kind == Kind::INT ? (double)integer : real;
+	}
+};
+
+//False for an int literal too large for C's int, which C would give a wider type
+inline bool read_constant(string_view value, VarType type, Constant& constant)
+{
+	if (type == VarType::STRING)
+	{
+		constant.kind = Constant::Kind::TEXT;
+		constant.text = value;
+		return true;
+	}
+
+	if (value == "true" || value == "false")
+	{
+		constant.kind = Constant::Kind::INT;
+		constant.integer = value == "true";
+		return true;
+	}
+
+	//Folded negatives are parenthesized
+	string text(value.front() == '(' ? value.substr(1, value.size() - 2) : value);
+
+	if (text.back() == 'f')
+	{
+		constant.kind = Constant::Kind::FLOAT;
+		constant.real = strtof(text.c_str(), nullptr);
+	}
+	else if (text.find_first_of(".eE") != string::npos)
+	{
+		constant.kind = Constant::Kind::DOUBLE;
+		constant.real = strtod(text.c_str(), nullptr);
+	}
+	else
+	{
+		constant.kind = Constant::Kind::INT;
+		constant.integer = strtoll(text.c_str(), nullptr, 0);
+
+		return constant.integer <= INT_MAX;
+	}
+
+	return true;
+}
+
+//C literal text reproducing the value exactly, in the C type it was computed in
+inline string constant_text(const Constant& constant, VarType type)
+{
+	if (constant.kind == Constant::Kind::TEXT)
+		return string(constant.text);
+
+	if (type == VarType::BOOL)
+		return constant.number() != 0 ? "true" : "false";
+
+	string text;
+
+	if (constant.kind == Constant::Kind::INT)
+		text = to_string(constant.integer);
+	else
+	{
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), constant.kind == Constant::Kind::FLOAT ? "%.9g" : "%.17g", constant.real);
+		text = buffer;
+
+		if (text.find_first_of(".e") == string::npos)
+			text += ".0";
+
+		if (constant.kind == Constant::Kind::FLOAT)
+			text += "f";
+	}
+
+	return text[0] == '-' ? "(" + text + ")" : text;
+}
+
+//Bytes of a string literal. False when it uses an escape other than C's single-character ones,
+//since octal and hex escapes can change meaning when literals are joined.
+inline bool decode_literal(string_view text, string& bytes)
+{
+	for (size_t i = 0; i < text.size(); ++i)
+	{
+		if (text[i] != '\\')
+		{
+			bytes += text[i];
+			continue;
+		}
+
+		if (++i == text.size())
+			return false;
+
+		switch (text[i])
+		{
+		case 'n': bytes += '\n'; break;
+		case 't': bytes += '\t'; break;
+		case 'r': bytes += '\r'; break;
+		case 'a': bytes += '\a'; break;
+		case 'b': bytes += '\b'; break;
+		case 'f': bytes += '\f'; break;
+		case 'v': bytes += '\v'; break;
+		case '\\':
+		case '\'':
+		case '"':
+		case '?':
+			bytes += text[i];
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//Arithmetic or comparison in one C type; a comparison leaves its result in truth
+template<typename T>
+inline bool apply_operator(string_view op, T a, T b, T& value, int& truth)
+{
+	truth = -1;
+
+	if (op == "+")
+		value = a + b;
+	else if (op == "-")
+		value = a - b;
+	else if (op == "*")
+		value = a * b;
+	else if (op == "/")
+	{
+		if (b == 0)
+			return false;
+
+		value = a / b;
+	}
+	else if (op == "==")
+		truth = a == b;
+	else if (op == "!=")
+		truth = a != b;
+	else if (op == "<")
+		truth = a < b;
+	else if (op == ">")
+		truth = a > b;
+	else if (op == "<=")
+		truth = a <= b;
+	else if (op == ">=")
+		truth = a >= b;
+	else
+		return false;
+
+	return true;
+}
+
+//Binary operator on two constants with C's arithmetic conversions. False when the result is not
+//exactly known at compile time: int overflow, division by zero, or a non-finite float.
+inline bool fold_operator(Arena& arena, string_view op, const Constant& left, const Constant& right, Constant& result)
+{
+	if (left.kind == Constant::Kind::TEXT)
+	{
+		string a, b;
+
+		if (!decode_literal(left.text, a) || !decode_literal(right.text, b))
+			return false;
+
+		if (op == "+")
+		{
+			result.kind = Constant::Kind::TEXT;
+			result.text = arena.copy_string(string(left.text) + string(right.text));
+			return true;
+		}
+
+		//Bytes compare unsigned, then the shorter string first, as string_compare does
+		int order = a.compare(b);
+		int truth;
+
+		if (!apply_operator(op, order, 0, order, truth) || truth < 0)
+			return false;
+
+		result.kind = Constant::Kind::INT;
+		result.integer = truth;
+		return true;
+	}
+
+	if (op == "&&" || op == "||")
+	{
+		result.kind = Constant::Kind::INT;
+		result.integer = op == "&&" ? left.number() != 0 && right.number() != 0 : left.number() != 0 || right.number() != 0;
+		return true;
+	}
+
+	Constant::Kind kind = max(left.kind, right.kind);
+	int truth;
+
+	if (kind == Constant::Kind::INT)
+	{
+		long long value = 0;
+
+		if (!apply_operator(op, left.integer, right.integer, value, truth))
+			return false;
+
+		if (truth < 0 && (value <= INT_MIN || value > INT_MAX))
+			return false;
+
+		result.integer = truth < 0 ? value : truth;
+	}
+	else if (kind == Constant::Kind::FLOAT)
+	{
+		float value = 0;
+
+		if (!apply_operator(op, (float)left.number(), (float)right.number(), value, truth))
+			return false;
+
+		result.real = value;
+		result.integer = truth;
+	}
+	else
+	{
+		double value = 0;
+
+		if (!apply_operator(op, left.number(), right.number(), value, truth))
+			return false;
+
+		result.real = value;
+		result.integer = truth;
+	}
+
+	if (truth >= 0)
+	{
+		result.kind = Constant::Kind::INT;
+		return true;
+	}
+
+	result.kind = kind;
+
+	return kind == Constant::Kind::INT || isfinite(result.real);
+}
+
+//---EXPRESSIONS---
+//Heap temporaries a statement owns while it is generated. Each is released once the statement
+//completes, unless a variable, return value or container takes it over first.
+using TempList = vector<pair<string, CollectionType>>;
+
+//Transfers a temporary out of the statement, so it is neither copied nor released. False when
+//the value is not an owned temporary.
+inline bool take_temp(TempList& temps, const string& value)
+{
+	for (auto it = temps.begin(); it != temps.end(); ++it)
+	{
+		if (it->first == value)
+		{
+			temps.erase(it);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+inline void free_temps(Emitter& out, TempList& temps)
+{
+	for (auto it = temps.rbegin(); it != temps.rend(); ++it)
+		out.line(free_c(it->first, it->second));
+
+	temps.clear();
+}
+
+struct FunctionNode;
+
+//Variables read and functions called by a piece of code, and the variables it assigns, each
+//marked true while every assignment to it is free of effects. Functions defined in it are listed
+//so calls to them can be followed.
+struct Uses
+{
+	set<string_view> variables;
+	set<string_view> functions;
+	map<string_view, bool> assigned;
+	map<string_view, const FunctionNode*> defined;
+};
+
+//Expression Node
+struct ExprNode
+{
+	CollectionType type;
+
+	ExprNode(CollectionType t) : type(t) {}
+
+	//Emits any statements the value depends on and returns the C value expression
+	virtual string lower(Emitter& out, TempList& gc_strings) const = 0;
+
+	//True when the value aliases an existing object instead of creating a new one
+	virtual bool borrows() const
+	{
+		return false;
+	}
+
+	//Folds constant subexpressions and returns the node to use in this one's place
+	virtual ExprNode* fold(Arena&)
+	{
+		return this;
+	}
+
+	virtual void collect_uses(Uses&) const {}
+
+	//True when evaluating the value does more than compute it: a call, or a lookup that can fail
+	virtual bool has_effects() const
+	{
+		return false;
+	}
+};
+
+//Child lists live in the same arena as the nodes
+using ExprList = ArenaVector<ExprNode*>;
+
+//Shared by a variable's declaration and every reference to it. A variable that is never
+//reassigned holds its initializer for its whole life, so a literal initializer replaces its
+//references.
+struct ConstantSlot
+{
+	ExprNode* value = nullptr;
+	bool reassigned = false;
+};
+
+//Value to store in a container, which owns its strings: temporaries and literals are moved in,
+//anything still aliased elsewhere is copied
+inline string stored_value(TempList& temps, const string& value, const ExprNode& expr)
+{
+	if (expr.type.base_type != VarType::STRING || take_temp(temps, value) || !expr.borrows())
+		return value;
+
+	return "string_copy(" + value + ")";
+}
+
+inline vector<string> lower_all(const ExprList& exprs, Emitter& out, TempList& gc_strings)
+{
+	vector<string> values;
+
+	for (const auto& expr : exprs)
+		values.push_back(expr->lower(out, gc_strings));
+
+	return values;
+}
+
+inline void fold_all(ExprList& exprs, Arena& arena)
+{
+	for (auto& expr : exprs)
+		expr = expr->fold(arena);
+}
+
+inline void collect_all(const ExprList& exprs, Uses& uses)
+{
+	for (const auto& expr : exprs)
+		expr->collect_uses(uses);
+}
+
+inline bool any_effects(const ExprList& exprs)
+{
+	for (const auto& expr : exprs)
+	{
+		if (expr->has_effects())
+			return true;
+	}
+
+	return false;
+}
+
+inline string join_args(const vector<string>& args)
+{
+	string code;
+
+	for (size_t i = 0; i < args.size(); ++i)
+	{
+		code += args[i];
+
+		if (i < args.size() - 1)
+			code += ", ";
+	}
+
+	return code;
+}
+
+//Number, String, and Boolean Literals
+struct LiteralNode : public ExprNode
+{
+	string_view value;
+
+	LiteralNode(string_view v, CollectionType t) : ExprNode(t), value(v) {}
+
+	string lower(Emitter&, TempList&) const override
+	{
+		if (type.base_type == VarType::STRING)
+			return "string_literal(\"" + string(value) + "\")";
+
+		return string(value);
+	}
+
+	static bool read(const ExprNode* node, Constant& constant)
+	{
+		auto literal = dynamic_cast<const LiteralNode*>(node);
+
+		return literal && read_constant(literal->value, literal->type.base_type, constant);
+	}
+
+	static LiteralNode* make(Arena& arena, const Constant& constant, CollectionType type)
+	{
+		return arena.make<LiteralNode>(arena.copy_string(constant_text(constant, type.base_type)), type);
+	}
+};
+
+struct VarNode : public ExprNode
+{
+	string_view name;
+	ConstantSlot* constant;
+
+	VarNode(string_view n, CollectionType t, ConstantSlot* c = nullptr) : ExprNode(t), name(n), constant(c) {}
+
+	string lower(Emitter&, TempList&) const override
+	{
+		return string(name);
+	}
+
+	bool borrows() const override
+	{
+		return true;
+	}
+
+	ExprNode* fold(Arena&) override
+	{
+		if (constant && !constant->reassigned && constant->value)
+			return constant->value;
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		uses.variables.insert(name);
+	}
+};
+
+struct CallExprNode : public ExprNode
+{
+	string_view func_name;
+	ExprList args;
+
+	CallExprNode(string_view fn, ExprList a, CollectionType rt) : ExprNode(rt), func_name(fn), args(move(a)) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		string call = string(func_name) + "(" + join_args(lower_all(args, out, gc_strings)) + ")";
+
+		if (!is_heap_type(type.base_type))
+			return call;
+
+		//The caller owns a returned heap value, so it is bound to a temporary that can be released.
+		//string_data also reads its argument twice, so a string must be evaluated only once.
+		string temp_var = out.temp(type.base_type == VarType::STRING ? "temp_string" : "temp_call");
+		out.line(c_type(type), " ", temp_var, " = ", call, ";");
+		gc_strings.emplace_back(temp_var, type);
+
+		return temp_var;
+	}
+
+	ExprNode* fold(Arena& arena) override
+	{
+		fold_all(args, arena);
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		uses.functions.insert(func_name);
+		collect_all(args, uses);
+	}
+
+	bool has_effects() const override
+	{
+		return true;
+	}
+};
+
+struct IndexNode : public ExprNode
+{
+	string_view var;
+	CollectionType var_type;
+	ExprNode* index;
+
+	IndexNode(string_view v, CollectionType vt, ExprNode* i, CollectionType t) : ExprNode(t), var(v), var_type(vt), index(i) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		string index_value = index->lower(out, gc_strings);
+
+		if (var_type.base_type == VarType::DICT)
+			return "dict_get_string_" + vartype_to_c(var_type.value_type) + "(" + string(var) + ", " + index_value + ")";
+
+		return string(var) + "->data[" + index_value + "]";
+	}
+
+	bool borrows() const override
+	{
+		return true;
+	}
+
+	ExprNode* fold(Arena& arena) override
+	{
+		index = index->fold(arena);
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		uses.variables.insert(var);
+		index->collect_uses(uses);
+	}
+
+	//A missing dict key ends the program
+	bool has_effects() const override
+	{
+		return var_type.base_type == VarType::DICT || index->has_effects();
+	}
+};
+
+struct MethodExprNode : public ExprNode
+{
+	string_view var;
+	string_view method;
+	CollectionType var_type;
+	ExprList args;
+
+	MethodExprNode(string_view v, string_view m, CollectionType vt, ExprList a, CollectionType rt) :
+		ExprNode(rt), var(v), method(m), var_type(vt), args(move(a)) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		string call = method_call_c(var, method, lower_all(args, out, gc_strings), var_type);
+
+		if (!is_heap_type(type.base_type))
+			return call;
+
+		//Heap results are bound to a temporary so they can be released
+		string temp_var = out.temp("temp_method");
+		out.line(c_type(type), " ", temp_var, " = ", call, ";");
+		gc_strings.emplace_back(temp_var, type);
+
+		return temp_var;
+	}
+
+	ExprNode* fold(Arena& arena) override
+	{
+		fold_all(args, arena);
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		uses.variables.insert(var);
+		collect_all(args, uses);
+	}
+
+	bool has_effects() const override
+	{
+		return any_effects(args);
+	}
+};
+
+struct BinOpNode : public ExprNode
+{
+	string_view op;
+	ExprNode* left;
+	ExprNode* right;
+
+	BinOpNode(string_view o, ExprNode* l, ExprNode* r, CollectionType t) : ExprNode(t), op(o), left(l), right(r) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		string left_value = left->lower(out, gc_strings);
+
+		if (op == "&&" || op == "||")
+			return lower_logic(out, left_value);
+
+		string right_value = right->lower(out, gc_strings);
+
+		if (left->type.base_type != VarType::STRING)
+			return "(" + left_value + " " + string(op) + " " + right_value + ")";
+
+		if (op == "==")
+			return "string_equals(" + left_value + ", " + right_value + ")";
+		else if (op == "!=")
+			return "!string_equals(" + left_value + ", " + right_value + ")";
+		else if (op != "+")
+			return "(string_compare(" + left_value + ", " + right_value + ") " + string(op) + " 0)";
+
+		string temp_var = out.temp("temp_string");
+		out.line("String ", temp_var, " = string_concat(", left_value, ", ", right_value, ");");
+		gc_strings.emplace_back(temp_var, type);
+
+		return temp_var;
+	}
+
+	ExprNode* fold(Arena& arena) override
+	{
+		left = left->fold(arena);
+		right = right->fold(arena);
+
+		Constant left_value, right_value, result;
+
+		if (!LiteralNode::read(left, left_value))
+			return this;
+
+		//A known left operand decides and / or, or leaves just the right one, as C's short circuit does
+		if (op == "&&" || op == "||")
+		{
+			if ((left_value.number() != 0) == (op == "||"))
+				return LiteralNode::make(arena, left_value, type);
+
+			if (right->type.base_type == VarType::BOOL)
+				return right;
+		}
+
+		if (LiteralNode::read(right, right_value) && fold_operator(arena, op, left_value, right_value, result))
+			return LiteralNode::make(arena, result, type);
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		left->collect_uses(uses);
+		right->collect_uses(uses);
+	}
+
+	bool has_effects() const override
+	{
+		return left->has_effects() || right->has_effects();
+	}
+
+private:
+	//The right operand only runs when the left one does not decide the result. When it needs
+	//setup, such as a call bound to a temporary, that setup and its temporaries are moved into a
+	//branch taken only in that case.
+	string lower_logic(Emitter& out, const string& left_value) const
+	{
+		ostringstream setup;
+		Emitter setup_out(setup, out, out.depth() + 1);
+		TempList right_temps;
+		string right_value = right->lower(setup_out, right_temps);
+
+		if (setup.tellp() == 0)
+			return "(" + left_value + " " + string(op) + " " + right_value + ")";
+
+		string temp_var = out.temp("temp_logic");
+		out.line("int ", temp_var, " = ", left_value, ";");
+		out.line(op == "&&" ? "if (" : "if (!", temp_var, ")");
+		out.open_block();
+		out.raw(setup.str());
+		out.line(temp_var, " = ", right->type.base_type == VarType::BOOL ? "" : "!!", right_value, ";");
+		free_temps(out, right_temps);
+		out.close_block();
+
+		return temp_var;
+	}
+};
+
+//Literal text, or an expression with an optional printf conversion from its format spec
+struct FStringPiece
+{
+	string_view text;
+	ExprNode* expr;
+	string_view conversion;
+};
+
+//Built by appending each piece to one growable string, sized up front for everything whose
+//length is known before the pieces are formatted
+struct FStringNode : public ExprNode
+{
+	ArenaVector<FStringPiece> pieces;
+
+	FStringNode(ArenaVector<FStringPiece> p) :
+		ExprNode({ VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE }), pieces(move(p)) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		vector<string> values;
+		size_t fixed = 0;
+		string lengths;
+
+		for (const auto& piece : pieces)
+		{
+			values.push_back(piece.expr ? piece.expr->lower(out, gc_strings) : string());
+
+			//A string looked up from a container is read once into a handle, since string_data
+			//and the length below would each repeat the lookup
+			if (piece.expr && piece.expr->type.base_type == VarType::STRING && !is_identifier(values.back()))
+			{
+				string handle = out.temp("temp_piece");
+				out.line("String ", handle, " = ", values.back(), ";");
+				values.back() = handle;
+			}
+
+			if (!piece.expr)
+				fixed += piece.text.size();
+			else if (!piece.conversion.empty())
+				continue;
+			else if (piece.expr->type.base_type == VarType::INT)
+				fixed += 11;
+			else if (piece.expr->type.base_type == VarType::BOOL)
+				fixed += 5;
+			else if (piece.expr->type.base_type == VarType::STRING)
+				lengths += " + " + values.back() + ".length";
+		}
+
+		string temp_var = out.temp("temp_string");
+		out.line("String ", temp_var, " = string_builder(", fixed, lengths, ");");
+
+		for (size_t i = 0; i < pieces.size(); ++i)
+			out.line(append_piece(temp_var, pieces[i], values[i]));
+
+		gc_strings.emplace_back(temp_var, type);
+
+		return temp_var;
+	}
+
+	ExprNode* fold(Arena& arena) override
+	{
+		for (auto& piece : pieces)
+		{
+			if (piece.expr)
+				piece.expr = piece.expr->fold(arena);
+		}
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		for (const auto& piece : pieces)
+		{
+			if (piece.expr)
+				piece.expr->collect_uses(uses);
+		}
+	}
+
+	bool has_effects() const override
+	{
+		for (const auto& piece : pieces)
+		{
+			if (piece.expr && piece.expr->has_effects())
+				return true;
+		}
+
+		return false;
+	}
+
+private:
+	static bool is_identifier(const string& value)
+	{
+		for (char c : value)
+		{
+			if (!isalnum((unsigned char)c) && c != '_')
+				return false;
+		}
+
+		return !value.empty();
+	}
+
+	static string append_piece(const string& target, const FStringPiece& piece, const string& value)
+	{
+		if (!piece.expr)
+			return "string_append(&" + target + ", string_literal(\"" + string(piece.text) + "\"));";
+
+		const CollectionType& type = piece.expr->type;
+		string printed = type.base_type == VarType::BOOL ? value + " ? \"true\" : \"false\"" : to_string_c(value, type);
+
+		if (!piece.conversion.empty())
+			return "string_append_format(&" + target + ", \"" + string(piece.conversion) + "\", " + printed + ");";
+		else if (type.base_type == VarType::INT)
+			return "string_append_int(&" + target + ", " + value + ");";
+		else if (type.base_type == VarType::FLOAT)
+			return "string_append_float(&" + target + ", " + value + ");";
+		else if (type.base_type == VarType::STRING)
+			return "string_append(&" + target + ", " + value + ");";
+		else if (type.base_type == VarType::BOOL)
+			return "string_append(&" + target + ", " + value + " ? string_literal(\"true\") : string_literal(\"false\"));";
+
+		return "string_append_text(&" + target + ", " + printed + ");";
+	}
+
+};
+
+struct ListNode : public ExprNode
+{
+	ExprList elements;
+
+	ListNode(ExprList elems, CollectionType t) : ExprNode(t), elements(move(elems)) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		vector<string> values = lower_all(elements, out, gc_strings);
+		string temp_var = out.temp("temp_list");
+
+		out.line(c_type(type), " ", temp_var, " = create_list_", vartype_to_c(type.element_type), "(", values.size(), ");");
+
+		for (size_t i = 0; i < values.size(); ++i)
+			out.line(temp_var, "->data[", i, "] = ", stored_value(gc_strings, values[i], *elements[i]), ";");
+
+		gc_strings.emplace_back(temp_var, type);
+
+		return temp_var;
+	}
+
+	ExprNode* fold(Arena& arena) override
+	{
+		fold_all(elements, arena);
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		collect_all(elements, uses);
+	}
+
+	bool has_effects() const override
+	{
+		return any_effects(elements);
+	}
+};
+
+struct TupleNode : public ExprNode
+{
+	ExprList elements;
+
+	TupleNode(ExprList elems, CollectionType t) : ExprNode(t), elements(move(elems)) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		vector<string> values = lower_all(elements, out, gc_strings);
+		string temp_var = out.temp("temp_tuple");
+
+		out.line(c_type(type), " ", temp_var, " = create_tuple_", vartype_to_c(type.element_type), "(", values.size(), ");");
+
+		for (size_t i = 0; i < values.size(); ++i)
+			out.line(temp_var, "->data[", i, "] = ", stored_value(gc_strings, values[i], *elements[i]), ";");
+
+		gc_strings.emplace_back(temp_var, type);
+
+		return temp_var;
+	}
+
+	ExprNode* fold(Arena& arena) override
+	{
+		fold_all(elements, arena);
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		collect_all(elements, uses);
+	}
+
+	bool has_effects() const override
+	{
+		return any_effects(elements);
+	}
+};
+
+struct DictNode : public ExprNode
+{
+	ArenaVector<pair<ExprNode*, ExprNode*>> entries;
+
+	DictNode(ArenaVector<pair<ExprNode*, ExprNode*>> e, CollectionType t) : ExprNode(t), entries(move(e)) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		vector<pair<string, string>> values;
+
+		for (const auto& entry : entries)
+		{
+			string key = entry.first->lower(out, gc_strings);
+			values.emplace_back(key, stored_value(gc_strings, entry.second->lower(out, gc_strings), *entry.second));
+		}
+
+		string temp_var = out.temp("temp_dict");
+		string value_c = vartype_to_c(type.value_type);
+
+		out.line(c_type(type), " ", temp_var, " = create_dict_string_", value_c, "();");
+
+		for (const auto& value : values)
+			out.line("dict_set_string_", value_c, "(", temp_var, ", ", value.first, ", ", value.second, ");");
+
+		gc_strings.emplace_back(temp_var, type);
+
+		return temp_var;
+	}
+
+	ExprNode* fold(Arena& arena) override
+	{
+		for (auto& entry : entries)
+		{
+			entry.first = entry.first->fold(arena);
+			entry.second = entry.second->fold(arena);
+		}
+
+		return this;
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		for (const auto& entry : entries)
+		{
+			entry.first->collect_uses(uses);
+			entry.second->collect_uses(uses);
+		}
+	}
+
+	bool has_effects() const override
+	{
+		for (const auto& entry : entries)
+		{
+			if (entry.first->has_effects() || entry.second->has_effects())
+				return true;
+		}
+
+		return false;
+	}
+};
+
+struct LenNode : public ExprNode
+{
+	ExprNode* expr;
+
+	LenNode(ExprNode* e) : ExprNode({ VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE }), expr(e) {}
+
+	string lower(Emitter& out, TempList& gc_strings) const override
+	{
+		string value = expr->lower(out, gc_strings);
+
+		if (expr->type.base_type == VarType::STRING)
+			return value + ".length";
+		else
+			return value + "->size";
+	}
+
+	//A string literal, or a list or tuple built only from literals, has a known length
+	ExprNode* fold(Arena& arena) override
+	{
+		expr = expr->fold(arena);
+
+		Constant value, length;
+		string bytes;
+		const ExprList* elements = nullptr;
+
+		if (auto list = dynamic_cast<ListNode*>(expr))
+			elements = &list->elements;
+		else if (auto tuple = dynamic_cast<TupleNode*>(expr))
+			elements = &tuple->elements;
+
+		if (LiteralNode::read(expr, value) && decode_literal(value.text, bytes))
+			length.integer = bytes.size();
+		else if (elements && all_literals(*elements))
+			length.integer = elements->size();
+		else
+			return this;
+
+		return LiteralNode::make(arena, length, type);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		expr->collect_uses(uses);
+	}
+
+	bool has_effects() const override
+	{
+		return expr->has_effects();
+	}
+
+private:
+	static bool all_literals(const ExprList& elements)
+	{
+		for (const auto& element : elements)
+		{
+			if (!dynamic_cast<const LiteralNode*>(element))
+				return false;
+		}
+
+		return true;
+	}
+};
+
+//1 or 0 for a condition folded to a constant, -1 when it is only known at run time
+inline int known_truth(const ExprNode* condition)
+{
+	Constant value;
+
+	if (!LiteralNode::read(condition, value) || value.kind == Constant::Kind::TEXT)
+		return -1;
+
+	return value.number() != 0;
+}
+
+//---ABSTRACT SYNTAX TREE---
+//Abstract Syntax Tree
+struct ASTNode
+{
+	virtual void generate_c_code(Emitter& out, TempList& gc_strings) const = 0;
+
+	//True when control never falls off the end of the statement
+	virtual bool exits() const
+	{
+		return false;
+	}
+
+	//Folds constants in the statement's expressions and nested blocks
+	virtual void fold(Arena&) {}
+
+	//What the statement and its nested blocks read, assign and call
+	virtual void collect_uses(Uses&) const {}
+
+	//Drops unreachable code, and assignments to the unused variables, from the statement and its
+	//nested blocks. Returns the statement to keep in this one's place, or null when nothing is left.
+	virtual ASTNode* prune(Arena&, const set<string_view>&)
+	{
+		return this;
+	}
+};
+
+using NodeList = ArenaVector<ASTNode*>;
+using LocalList = ArenaVector<pair<string_view, CollectionType>>;
+
+//Statement list plus the heap locals declared directly in it, which the block owns
+struct Block
+{
+	NodeList statements;
+	LocalList owned;
+
+	Block(Arena& arena) : statements(arena), owned(arena) {}
+};
+
+//Releases locals in reverse declaration order, skipping one that is being handed back
+inline void free_locals(Emitter& out, const LocalList& locals, string_view keep = string_view())
+{
+	for (auto it = locals.rbegin(); it != locals.rend(); ++it)
+	{
+		if (it->first != keep)
+			out.line(free_c(it->first, it->second));
+	}
+}
+
+//Temporaries of a statement that exits are released by the statement itself
+inline void generate_statement(Emitter& out, const ASTNode& node)
+{
+	TempList temps;
+	node.generate_c_code(out, temps);
+
+	if (!node.exits())
+		free_temps(out, temps);
+}
+
+inline void generate_statements(Emitter& out, const Block& block)
+{
+	for (const auto& node : block.statements)
+		generate_statement(out, *node);
+
+	if (block.statements.empty() || !block.statements.back()->exits())
+		free_locals(out, block.owned);
+}
+
+inline void generate_block(Emitter& out, const Block& block)
+{
+	out.open_block();
+	generate_statements(out, block);
+	out.close_block();
+}
+
+//Statements are visited in source order, so a variable's initializer is folded before any use
+inline void fold_block(Block& block, Arena& arena)
+{
+	for (auto& node : block.statements)
+		node->fold(arena);
+}
+
+inline void collect_block_uses(const Block& block, Uses& uses)
+{
+	for (const auto& node : block.statements)
+		node->collect_uses(uses);
+}
+
+inline void drop_locals(LocalList& locals, const set<string_view>& unused)
+{
+	for (auto it = locals.begin(); it != locals.end();)
+	{
+		if (unused.count(it->first))
+			it = locals.erase(it);
+		else
+			++it;
+	}
+}
+
+//Nothing after a statement that exits can run
+inline void prune_block(Block& block, Arena& arena, const set<string_view>& unused)
+{
+	NodeList kept(block.statements.get_allocator());
+
+	for (const auto& node : block.statements)
+	{
+		ASTNode* pruned = node->prune(arena, unused);
+
+		if (!pruned)
+			continue;
+
+		kept.push_back(pruned);
+
+		if (pruned->exits())
+			break;
+	}
+
+	block.statements = move(kept);
+	drop_locals(block.owned, unused);
+}
+
+//A branch known to be taken, kept as a block of its own so its locals stay scoped to it
+struct BlockNode : public ASTNode
+{
+	Block body;
+
+	BlockNode(Block b) : body(move(b)) {}
+
+	void generate_c_code(Emitter& out, TempList&) const override
+	{
+		generate_block(out, body);
+	}
+
+	bool exits() const override
+	{
+		return !body.statements.empty() && body.statements.back()->exits();
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		collect_block_uses(body, uses);
+	}
+
+	ASTNode* prune(Arena& arena, const set<string_view>& unused) override
+	{
+		prune_block(body, arena, unused);
+
+		return body.statements.empty() ? nullptr : this;
+	}
+};
+
+//Helper Code Node
+struct HelperNode : public ASTNode
+{
+	string_view code;
+
+	HelperNode(string_view c) : code(c) {}
+
+	void generate_c_code(Emitter& out, TempList&) const override
+	{
+		out.raw(code);
+	}
+};
+
+struct AssignNode : public ASTNode
+{
+	string_view var;
+	ExprNode* expr;
+	CollectionType type;
+	bool is_declaration;
+	bool release_previous;			//The variable owns its current value
+	bool move_source = false;		//expr is a local heap value read for the last time, so it is moved
+	ConstantSlot* constant = nullptr;	//Declaration of a variable that may never change
+
+	AssignNode(string_view v, ExprNode* e, CollectionType t, bool decl, bool release) :
+		var(v), expr(e), type(t), is_declaration(decl), release_previous(release) {}
+
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		if (type.base_type == VarType::STRING)
+		{
+			generate_string(out, gc_strings);
+			return;
+		}
+
+		string value = expr->lower(out, gc_strings);
+
+		//A collection variable owns its value, so one still held by another variable is copied
+		if (move_source)
+			value = move_c(value, type);
+		else if (is_heap_type(type.base_type) && !take_temp(gc_strings, value) && expr->borrows())
+		{
+			value = copy_c(value, type);
+
+			//The copy may be of the value being replaced, so it is made first
+			if (release_previous)
+			{
+				string temp_var = out.temp("temp_copy");
+				out.line(c_type(type), " ", temp_var, " = ", value, ";");
+				value = temp_var;
+			}
+		}
+
+		if (is_declaration)
+			out.line(c_type(type), " ", var, " = ", value, ";");
+		else
+		{
+			if (release_previous)
+				out.line(free_c(var, type));
+
+			out.line(var, " = ", value, ";");
+		}
+	}
+
+	void fold(Arena& arena) override
+	{
+		expr = expr->fold(arena);
+
+		//Only a variable can be moved from
+		if (!dynamic_cast<VarNode*>(expr))
+			move_source = false;
+
+		Constant value;
+
+		if (!constant || !LiteralNode::read(expr, value))
+			return;
+
+		//A float variable holds a float, whatever the initializer's C type
+		if (type.base_type == VarType::FLOAT)
+		{
+			value.real = (float)value.number();
+			value.kind = Constant::Kind::FLOAT;
+		}
+
+		constant->value = LiteralNode::make(arena, value, type);
+	}
+
+	//Reading the variable to assign it again does not make it used
+	void collect_uses(Uses& uses) const override
+	{
+		Uses read;
+		expr->collect_uses(read);
+		read.variables.erase(var);
+
+		uses.variables.insert(read.variables.begin(), read.variables.end());
+		uses.functions.insert(read.functions.begin(), read.functions.end());
+
+		auto assigned = uses.assigned.emplace(var, true).first;
+		assigned->second = assigned->second && !expr->has_effects();
+	}
+
+	ASTNode* prune(Arena&, const set<string_view>& unused) override
+	{
+		return unused.count(var) ? nullptr : this;
+	}
+
+private:
+	//Fresh temporaries, interned literals and last uses of another local are moved into the
+	//variable; anything still aliased elsewhere is copied. An owned variable reuses its buffer for
+	//copies, and `s = s + x` appends in place, so building a string in a loop is amortized linear.
+	//A literal is borrowed from static storage and only copied when the variable is first written.
+	void generate_string(Emitter& out, TempList& gc_strings) const
+	{
+		auto concat = dynamic_cast<BinOpNode*>(expr);
+		auto target = concat ? dynamic_cast<VarNode*>(concat->left) : nullptr;
+
+		if (release_previous && concat && concat->op == "+" && target && target->name == var)
+		{
+			out.line("string_append(&", var, ", ", concat->right->lower(out, gc_strings), ");");
+			return;
+		}
+
+		string value = expr->lower(out, gc_strings);
+
+		if (move_source)
+			value = move_c(value, type);
+
+		if (move_source || take_temp(gc_strings, value) || dynamic_cast<LiteralNode*>(expr))
+		{
+			if (is_declaration)
+				out.line("String ", var, " = ", value, ";");
+			else
+			{
+				if (release_previous)
+					out.line("free_string(", var, ");");
+
+				out.line(var, " = ", value, ";");
+			}
+		}
+		else if (is_declaration)
+			out.line("String ", var, " = string_copy(", value, ");");
+		else if (release_previous)
+			out.line("string_assign(&", var, ", ", value, ");");
+		else
+			out.line(var, " = string_copy(", value, ");");
+	}
+};
+
+//Element / Entry Assignment
+struct IndexAssignNode : public ASTNode
+{
+	string_view var;
+	CollectionType var_type;
+	ExprNode* index;
+	ExprNode* value;
+
+	IndexAssignNode(string_view v, CollectionType vt, ExprNode* i, ExprNode* val) : var(v), var_type(vt), index(i), value(val) {}
+
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		string index_value = index->lower(out, gc_strings);
+		string new_value = value->lower(out, gc_strings);
+
+		if (var_type.base_type == VarType::DICT)
+		{
+			string stored = stored_value(gc_strings, new_value, *value);
+			out.line("dict_set_string_", vartype_to_c(var_type.value_type), "(", var, ", ", index_value, ", ", stored, ");");
+		}
+		else if (var_type.element_type != VarType::STRING)
+			out.line(var, "->data[", index_value, "] = ", new_value, ";");
+		else if (take_temp(gc_strings, new_value) || !value->borrows())
+		{
+			//The list owns the element being replaced
+			out.line("free_string(", var, "->data[", index_value, "]);");
+			out.line(var, "->data[", index_value, "] = ", new_value, ";");
+		}
+		else
+			out.line("string_assign(&", var, "->data[", index_value, "], ", new_value, ");");
+	}
+
+	void fold(Arena& arena) override
+	{
+		index = index->fold(arena);
+		value = value->fold(arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		uses.variables.insert(var);
+		index->collect_uses(uses);
+		value->collect_uses(uses);
+	}
+};
+
+struct FunctionNode : public ASTNode
+{
+	string_view name;
+	LocalList args;					//Borrowed from the caller; one the body reassigns is copied and owned
+	CollectionType return_type;
+	Block body;
+	ArenaVector<string_view> callees;	//Functions called from the body, first call order
+	uint64_t cache_key;					//Hash of the body's tokens and the callees' signatures
+	RuntimeFeatures runtime;			//What a unit holding only this function needs
+
+	FunctionNode(string_view n, LocalList a, CollectionType rt, Arena& arena) :
+		name(n), args(move(a)), return_type(rt), body(arena), callees(arena), cache_key(0) {}
+
+	string signature() const
+	{
+		string signature = c_type(return_type) + " " + string(name) + "(";
+
+		for (size_t i = 0; i < args.size(); ++i)
+		{
+			const auto& arg = args[i];
+
+			signature += c_type(arg.second) + " " + string(arg.first);
+
+			if (i < args.size() - 1)
+				signature += ", ";
+		}
+
+		return signature + ")";
+	}
+
+	void generate_c_code(Emitter& out, TempList&) const override
+	{
+		out.reset_temps();
+		out.line(signature());
+		out.open_block();
+
+		//A parameter the body reassigns is owned like a local, so it starts as a copy
+		for (const auto& arg : args)
+		{
+			for (const auto& local : body.owned)
+			{
+				if (local.first == arg.first)
+					out.line(arg.first, " = ", copy_c(string(arg.first), arg.second), ";");
+			}
+		}
+
+		generate_statements(out, body);
+		out.close_block();
+		out.blank();
+	}
+
+	void fold(Arena& arena) override
+	{
+		fold_block(body, arena);
+	}
+
+	//The body is a frame of its own, so it is only read once a call to the function is reached
+	void collect_uses(Uses& uses) const override
+	{
+		uses.defined.emplace(name, this);
+	}
+};
+
+struct CallNode : public ASTNode
+{
+	string_view func_name;
+	ExprList args;
+	CollectionType return_type;
+
+	CallNode(string_view fn, ExprList a, CollectionType rt) : func_name(fn), args(move(a)), return_type(rt) {}
+
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		string call_args = join_args(lower_all(args, out, gc_strings));
+
+		if (is_heap_type(return_type.base_type))
+		{
+			string temp_var = out.temp("temp_call");
+
+			out.line(c_type(return_type), " ", temp_var, " = ", func_name, "(", call_args, ");");
+			gc_strings.emplace_back(temp_var, return_type);
+		}
+		else
+			out.line(func_name, "(", call_args, ");");
+	}
+
+	void fold(Arena& arena) override
+	{
+		fold_all(args, arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		uses.functions.insert(func_name);
+		collect_all(args, uses);
+	}
+};
+
+struct MethodCallNode : public ASTNode
+{
+	string_view var;
+	string_view method;
+	ExprList args;
+	CollectionType var_type;
+	CollectionType return_type;
+
+	MethodCallNode(string_view v, string_view m, ExprList a, CollectionType vt, CollectionType rt) :
+		var(v), method(m), args(move(a)), var_type(vt), return_type(rt) {}
+
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		vector<string> values = lower_all(args, out, gc_strings);
+
+		if (method == "append")
+			values[0] = stored_value(gc_strings, values[0], *args[0]);
+
+		string call = method_call_c(var, method, values, var_type);
+
+		//Nothing reads the result, so a heap one is released straight away
+		if (is_heap_type(return_type.base_type))
+			out.line(free_c(call, return_type));
+		else
+			out.line(call, ";");
+	}
+
+	void fold(Arena& arena) override
+	{
+		fold_all(args, arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		uses.variables.insert(var);
+		collect_all(args, uses);
+	}
+
+	//Only append changes anything; every other method just computes a result
+	ASTNode* prune(Arena&, const set<string_view>&) override
+	{
+		return return_type.base_type == VarType::NONE || any_effects(args) ? this : nullptr;
+	}
+};
+
+struct ReturnNode : public ASTNode
+{
+	ExprNode* expr;
+	LocalList live;					//Heap locals of the function still alive at this point
+
+	ReturnNode(ExprNode* e, LocalList l) : expr(e), live(move(l)) {}
+
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		string value = expr->lower(out, gc_strings);
+		bool moved = take_temp(gc_strings, value) || is_live(value);
+
+		//A returned local or temporary is handed to the caller; anything borrowed, such as an
+		//argument, is copied for it
+		if (is_heap_type(expr->type.base_type) && !moved && expr->borrows())
+			value = copy_c(value, expr->type);
+
+		out.line(c_type(expr->type), " return_value = ", value, ";");
+		free_temps(out, gc_strings);
+		free_locals(out, live, value);
+		out.line("return return_value;");
+	}
+
+	bool exits() const override
+	{
+		return true;
+	}
+
+	void fold(Arena& arena) override
+	{
+		expr = expr->fold(arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		expr->collect_uses(uses);
+	}
+
+	ASTNode* prune(Arena&, const set<string_view>& unused) override
+	{
+		drop_locals(live, unused);
+
+		return this;
+	}
+
+private:
+	bool is_live(const string& value) const
+	{
+		for (const auto& local : live)
+		{
+			if (local.first == value)
+				return true;
+		}
+
+		return false;
+	}
+};
+
+struct PrintNode : public ASTNode
+{
+	ExprList values;
+	string_view separator;
+
+	PrintNode(ExprList vals, string_view sep) : values(move(vals)), separator(sep) {}
+
+	//Each value goes straight to its formatter, building the line in one buffer that is handed to
+	//stdio in a single write. Values are evaluated first, so a print inside one of them comes out
+	//ahead of this line, as it would with printf.
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		vector<string> lowered = lower_all(values, out, gc_strings);
+		string line = out.temp("temp_line");
+
+		out.line("MinipyText* ", line, " = minipy_print_begin();");
+
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			const CollectionType& type = values[i]->type;
+
+			if (type.base_type == VarType::INT)
+				out.line("minipy_text_put_int(", line, ", ", lowered[i], ");");
+			else if (type.base_type == VarType::FLOAT)
+				out.line("minipy_print_float(", line, ", ", lowered[i], ");");
+			else if (type.base_type == VarType::BOOL)
+				out.line("minipy_text_put_bool(", line, ", ", lowered[i], ");");
+			else if (type.base_type == VarType::STRING)
+				out.line("minipy_print_string(", line, ", ", lowered[i], ");");
+			else
+				out.line("minipy_print_text(", line, ", ", to_string_c(lowered[i], type), ");");
+
+			if (i < values.size() - 1 && !separator.empty())
+				out.line("minipy_text_append(", line, ", \"", separator, "\", sizeof(\"", separator, "\") - 1);");
+		}
+
+		out.line("minipy_print_end(", line, ");");
+	}
+
+	void fold(Arena& arena) override
+	{
+		fold_all(values, arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		collect_all(values, uses);
+	}
+};
+
+struct IfNode : public ASTNode
+{
+	ExprNode* condition;
+	Block body;
+	ArenaVector<pair<ExprNode*, Block>> elif_clauses;
+	Block else_body;
+
+	IfNode(ExprNode* cond, Arena& arena) : condition(cond), body(arena), elif_clauses(arena), else_body(arena) {}
+
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		string condition_value = condition->lower(out, gc_strings);
+
+		out.line("if (", condition_value, ")");
+		generate_block(out, body);
+		generate_else(out, 0);
+	}
+
+	void fold(Arena& arena) override
+	{
+		condition = condition->fold(arena);
+		fold_block(body, arena);
+
+		for (auto& elif : elif_clauses)
+		{
+			elif.first = elif.first->fold(arena);
+			fold_block(elif.second, arena);
+		}
+
+		fold_block(else_body, arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		condition->collect_uses(uses);
+		collect_block_uses(body, uses);
+
+		for (const auto& elif : elif_clauses)
+		{
+			elif.first->collect_uses(uses);
+			collect_block_uses(elif.second, uses);
+		}
+
+		collect_block_uses(else_body, uses);
+	}
+
+	//Branches whose condition is known false go; one known true becomes the else and ends the chain
+	ASTNode* prune(Arena& arena, const set<string_view>& unused) override
+	{
+		vector<pair<ExprNode*, Block>> clauses;
+		vector<pair<ExprNode*, Block>> kept;
+		clauses.emplace_back(condition, move(body));
+
+		for (auto& elif : elif_clauses)
+			clauses.emplace_back(elif.first, move(elif.second));
+
+		for (auto& clause : clauses)
+		{
+			int truth = known_truth(clause.first);
+
+			if (truth == 1)
+			{
+				else_body = move(clause.second);
+				break;
+			}
+
+			if (truth == -1)
+				kept.push_back(move(clause));
+		}
+
+		prune_block(else_body, arena, unused);
+
+		if (kept.empty())
+			return else_body.statements.empty() ? nullptr : arena.make<BlockNode>(move(else_body));
+
+		elif_clauses.clear();
+
+		for (auto& clause : kept)
+		{
+			prune_block(clause.second, arena, unused);
+
+			if (&clause == &kept.front())
+			{
+				condition = clause.first;
+				body = move(clause.second);
+			}
+			else
+				elif_clauses.push_back(move(clause));
+		}
+
+		return this;
+	}
+
+private:
+	//An elif's condition is only evaluated once every branch before it has failed, so one that
+	//needs setup opens an else block holding that setup, its temporaries and the rest of the chain
+	void generate_else(Emitter& out, size_t index) const
+	{
+		if (index == elif_clauses.size())
+		{
+			if (!else_body.statements.empty())
+			{
+				out.line("else");
+				generate_block(out, else_body);
+			}
+
+			return;
+		}
+
+		const auto& elif = elif_clauses[index];
+		ostringstream setup;
+		Emitter setup_out(setup, out, out.depth() + 1);
+		TempList condition_temps;
+		string condition_value = elif.first->lower(setup_out, condition_temps);
+
+		if (setup.tellp() == 0)
+		{
+			out.line("else if (", condition_value, ")");
+			generate_block(out, elif.second);
+			generate_else(out, index + 1);
+			return;
+		}
+
+		out.line("else");
+		out.open_block();
+		out.raw(setup.str());
+
+		if (!condition_temps.empty())
+		{
+			string condition_var = out.temp("temp_condition");
+			out.line("int ", condition_var, " = ", condition_value, ";");
+			free_temps(out, condition_temps);
+			condition_value = condition_var;
+		}
+
+		out.line("if (", condition_value, ")");
+		generate_block(out, elif.second);
+		generate_else(out, index + 1);
+		out.close_block();
+	}
+};
+
+struct ForNode : public ASTNode
+{
+	string_view var;
+	ExprNode* start;
+	ExprNode* end;
+	Block body;
+
+	ForNode(string_view v, ExprNode* s, ExprNode* e, Arena& arena) : var(v), start(s), end(e), body(arena) {}
+
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		string start_value = start->lower(out, gc_strings);
+		string end_value = end->lower(out, gc_strings);
+
+		out.line("for (int ", var, " = ", start_value, "; ", var, " < ", end_value, "; ", var, "++)");
+		generate_block(out, body);
+	}
+
+	void fold(Arena& arena) override
+	{
+		start = start->fold(arena);
+		end = end->fold(arena);
+		fold_block(body, arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		start->collect_uses(uses);
+		end->collect_uses(uses);
+		collect_block_uses(body, uses);
+	}
+
+	//A range known to be empty never runs the body
+	ASTNode* prune(Arena& arena, const set<string_view>& unused) override
+	{
+		Constant first, last;
+
+		if (LiteralNode::read(start, first) && LiteralNode::read(end, last) && first.integer >= last.integer)
+			return nullptr;
+
+		prune_block(body, arena, unused);
+
+		return this;
+	}
+};
+
+struct WhileNode : public ASTNode
+{
+	ExprNode* condition;
+	Block body;
+
+	WhileNode(ExprNode* cond, Arena& arena) : condition(cond), body(arena) {}
+
+	void generate_c_code(Emitter& out, TempList&) const override
+	{
+		//Setup is captured separately since it has to move inside the loop, along with the
+		//temporaries it makes, which are released every iteration once the condition is tested
+		ostringstream setup;
+		Emitter setup_out(setup, out, out.depth() + 1);
+		TempList condition_temps;
+		string condition_value = condition->lower(setup_out, condition_temps);
+
+		if (setup.tellp() == 0)
+		{
+			out.line("while (", condition_value, ")");
+			generate_block(out, body);
+			return;
+		}
+
+		out.line("while (1)");
+		out.open_block();
+		out.raw(setup.str());
+
+		if (!condition_temps.empty())
+		{
+			string condition_var = out.temp("temp_condition");
+			out.line("int ", condition_var, " = ", condition_value, ";");
+			free_temps(out, condition_temps);
+			condition_value = condition_var;
+		}
+
+		out.line("if (!", condition_value, ")");
+		out.line("    break;");
+		generate_statements(out, body);
+		out.close_block();
+	}
+
+	void fold(Arena& arena) override
+	{
+		condition = condition->fold(arena);
+		fold_block(body, arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		condition->collect_uses(uses);
+		collect_block_uses(body, uses);
+	}
+
+	ASTNode* prune(Arena& arena, const set<string_view>& unused) override
+	{
+		if (known_truth(condition) == 0)
+			return nullptr;
+
+		prune_block(body, arena, unused);
+
+		return this;
+	}
+};
+
+struct MatchNode : public ASTNode
+{
+	ExprNode* expr;
+	ArenaVector<pair<string_view, Block>> cases;
+	Block default_case;
+
+	MatchNode(ExprNode* e, Arena& arena) : expr(e), cases(arena), default_case(arena) {}
+
+	void generate_c_code(Emitter& out, TempList& gc_strings) const override
+	{
+		string value = expr->lower(out, gc_strings);
+
+		out.line("switch (", value, ")");
+		out.open_block();
+
+		for (const auto& c : cases)
+		{
+			out.line("case ", c.first, ":");
+			generate_block(out, c.second);
+			out.line("break;");
+		}
+
+		if (!default_case.statements.empty())
+		{
+			out.line("default:");
+			generate_block(out, default_case);
+			out.line("break;");
+		}
+
+		out.close_block();
+	}
+
+	void fold(Arena& arena) override
+	{
+		expr = expr->fold(arena);
+
+		for (auto& c : cases)
+			fold_block(c.second, arena);
+
+		fold_block(default_case, arena);
+	}
+
+	void collect_uses(Uses& uses) const override
+	{
+		expr->collect_uses(uses);
+
+		for (const auto& c : cases)
+			collect_block_uses(c.second, uses);
+
+		collect_block_uses(default_case, uses);
+	}
+
+	//A known value selects its case up front
+	ASTNode* prune(Arena& arena, const set<string_view>& unused) override
+	{
+		for (auto& c : cases)
+			prune_block(c.second, arena, unused);
+
+		prune_block(default_case, arena, unused);
+
+		Constant value;
+
+		if (!LiteralNode::read(expr, value))
+			return this;
+
+		Block* chosen = &default_case;
+
+		for (auto& c : cases)
+		{
+			Constant pattern;
+
+			if (read_constant(c.first, expr->type.base_type, pattern) && pattern.integer == value.integer)
+			{
+				chosen = &c.second;
+				break;
+			}
+		}
+
+		return chosen->statements.empty() ? nullptr : arena.make<BlockNode>(move(*chosen));
+	}
+};
+
+//---DEAD CODE ELIMINATION---
+//Prunes a function body, or the module's own statements, until it settles, since dropping an
+//assignment can leave what it read unused in turn. A variable goes once nothing reads it and none
+//of its assignments has an effect; its releases go with it.
+inline void eliminate_frame(Block& body, Arena& arena)
+{
+	set<string_view> unused;
+	size_t found;
+
+	do
+	{
+		prune_block(body, arena, unused);
+
+		Uses uses;
+		collect_block_uses(body, uses);
+		found = unused.size();
+
+		for (const auto& assigned : uses.assigned)
+		{
+			if (assigned.second && !uses.variables.count(assigned.first))
+				unused.insert(assigned.first);
+		}
+	} while (unused.size() != found);
+}
+
+//Cleans every frame, then removes the functions main() can no longer reach
+inline void eliminate_dead_code(Block& program, Arena& arena)
+{
+	map<string_view, FunctionNode*> functions;
+
+	eliminate_frame(program, arena);
+
+	for (const auto& node : program.statements)
+	{
+		if (auto function = dynamic_cast<FunctionNode*>(node))
+		{
+			eliminate_frame(function->body, arena);
+			functions[function->name] = function;
+		}
+	}
+
+	Uses uses;
+	collect_block_uses(program, uses);
+
+	vector<string_view> pending(uses.functions.begin(), uses.functions.end());
+	map<string_view, const FunctionNode*> nested = move(uses.defined);
+	set<string_view> reached;
+
+	while (!pending.empty())
+	{
+		string_view name = pending.back();
+		pending.pop_back();
+
+		if (!reached.insert(name).second)
+			continue;
+
+		//A function defined inside a block is kept with it, so only its calls are followed
+		auto top_level = functions.find(name);
+		Uses called;
+
+		if (top_level == functions.end())
+		{
+			auto definition = nested.find(name);
+
+			if (definition == nested.end())
+				continue;
+
+			collect_block_uses(definition->second->body, called);
+		}
+		else
+		{
+			FunctionNode* function = top_level->second;
+			collect_block_uses(function->body, called);
+
+			//A call that was pruned away no longer needs the callee's prototype
+			for (auto it = function->callees.begin(); it != function->callees.end();)
+			{
+				if (called.functions.count(*it))
+					++it;
+				else
+					it = function->callees.erase(it);
+			}
+		}
+
+		nested.insert(called.defined.begin(), called.defined.end());
+		pending.insert(pending.end(), called.functions.begin(), called.functions.end());
+	}
+
+	NodeList kept(program.statements.get_allocator());
+
+	for (const auto& node : program.statements)
+	{
+		auto function = dynamic_cast<FunctionNode*>(node);
+
+		if (!function || reached.count(function->name))
+			kept.push_back(node);
+	}
+
+	program.statements = move(kept);
+}
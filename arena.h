@@ -0,0 +1,155 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//---ARENA---
+//Bump allocator; everything allocated from it is released at once when the arena is destroyed.
+//Destructors of arena objects never run, so they must not own memory outside the arena.
+class Arena
+{
+private:
+	struct Block
+	{
+		Block* next;
+		size_t size;
+	};
+
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	Block* head;
+	char* cursor;
+	char* limit;
+
+public:
+	struct Stats
+	{
+		size_t allocations = 0;			//Objects / buffers served from the arena
+		size_t bytes_used = 0;
+		size_t blocks = 0;				//Underlying malloc calls
+		size_t bytes_reserved = 0;
+	};
+
+	Arena() : head(nullptr), cursor(nullptr), limit(nullptr) {}
+
+	~Arena()
+	{
+		while (head)
+		{
+			Block* next = head->next;
+			free(head);
+			head = next;
+		}
+	}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* allocate(size_t size, size_t align)
+	{
+		char* start = align_up(cursor, align);
+
+		if (!cursor || start + size > limit)
+		{
+			new_block(size + align);
+			start = align_up(cursor, align);
+		}
+
+		cursor = start + size;
+		stats.allocations++;
+		stats.bytes_used += size;
+
+		return start;
+	}
+
+	template<typename T, typename... Args>
+	T* make(Args&&... args)
+	{
+		return new (allocate(sizeof(T), alignof(T))) T(forward<Args>(args)...);
+	}
+
+	string_view copy_string(string_view text)
+	{
+		if (text.empty())
+			return text;
+
+		char* data = (char*)allocate(text.size(), 1);
+		memcpy(data, text.data(), text.size());
+
+		return string_view(data, text.size());
+	}
+
+	const Stats& get_stats() const
+	{
+		return stats;
+	}
+
+private:
+	Stats stats;
+
+	static char* align_up(char* p, size_t align)
+	{
+		return (char*)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+	}
+
+	void new_block(size_t min_size)
+	{
+		size_t size = min_size + sizeof(Block) > BLOCK_SIZE ? min_size + sizeof(Block) : BLOCK_SIZE;
+		Block* block = (Block*)malloc(size);
+
+		if (!block)
+			throw bad_alloc();
+
+		block->next = head;
+		block->size = size;
+		head = block;
+		cursor = (char*)(block + 1);
+		limit = (char*)block + size;
+
+		stats.blocks++;
+		stats.bytes_reserved += size;
+	}
+};
+
+//STL allocator drawing from an Arena; deallocation is a no-op
+template<typename T>
+struct ArenaAllocator
+{
+	using value_type = T;
+
+	Arena* arena;
+
+	ArenaAllocator(Arena& a) : arena(&a) {}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t n)
+	{
+		return (T*)arena->allocate(n * sizeof(T), alignof(T));
+	}
+
+	void deallocate(T*, size_t) {}
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const
+	{
+		return arena == other.arena;
+	}
+
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const
+	{
+		return arena != other.arena;
+	}
+};
+
+template<typename T>
+using ArenaVector = vector<T, ArenaAllocator<T>>;
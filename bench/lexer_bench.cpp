@@ -0,0 +1,187 @@
+//Lexer micro-benchmark: identifier classification and end-to-end tokenizing throughput
+//Build: g++ -std=c++17 -O2 bench/lexer_bench.cpp -o lexer_bench
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../lexer.h"
+
+using namespace std;
+
+//Keyword recognition as a linear comparison chain (the previous lexer)
+TokenType classify_linear(string_view value)
+{
+	if (value == "def")
+		return TokenType::DEF;
+
+	if (value == "return")
+		return TokenType::RETURN;
+
+	if (value == "print")
+		return TokenType::PRINT;
+
+	if (value == "int")
+		return TokenType::INT;
+
+	if (value == "float")
+		return TokenType::FLOAT;
+
+	if (value == "string")
+		return TokenType::STRING;
+
+	if (value == "bool")
+		return TokenType::BOOL;
+
+	if (value == "list")
+		return TokenType::LIST;
+
+	if (value == "tuple")
+		return TokenType::TUPLE;
+
+	if (value == "dict")
+		return TokenType::DICT;
+
+	if (value == "if")
+		return TokenType::IF;
+
+	if (value == "elif")
+		return TokenType::ELIF;
+
+	if (value == "else")
+		return TokenType::ELSE;
+
+	if (value == "for")
+		return TokenType::FOR;
+
+	if (value == "in")
+		return TokenType::IN;
+
+	if (value == "range")
+		return TokenType::RANGE;
+
+	if (value == "while")
+		return TokenType::WHILE;
+
+	if (value == "match")
+		return TokenType::MATCH;
+
+	if (value == "case")
+		return TokenType::CASE;
+
+	if (value == "true")
+		return TokenType::TRUE;
+
+	if (value == "false")
+		return TokenType::FALSE;
+
+	if (value == "and")
+		return TokenType::AND;
+
+	if (value == "or")
+		return TokenType::OR;
+
+	if (value == "not")
+		return TokenType::NOT;
+
+	if (value == "sep")
+		return TokenType::SEP;
+
+	if (value == "len")
+		return TokenType::LEN;
+
+	if (value == "append" || value == "upper" || value == "lower" || value == "strip" ||
+		value == "replace" || value == "split" || value == "find")
+		return TokenType::CALL_METHOD;
+
+	return TokenType::IDENTIFIER;
+}
+
+//Synthetic MiniPy source with a typical identifier / keyword mix
+string make_source(size_t target_bytes)
+{
+	string source;
+	size_t block = 0;
+
+	while (source.size() < target_bytes)
+	{
+		string n = to_string(block++);
+
+		source += "def compute_" + n + "(int count_" + n + ", float scale): float:\n";
+		source += "    float total = 0.0\n";
+		source += "    for index in range(0, count_" + n + "):\n";
+		source += "        if index > 10 and index < 100:\n";
+		source += "            float total = total + scale * index\n";
+		source += "        else:\n";
+		source += "            float total = total - scale\n";
+		source += "    return total\n";
+		source += "string label_" + n + " = \"block\"\n";
+		source += "string upper_" + n + " = label_" + n + ".upper()\n";
+		source += "print(compute_" + n + "(" + n + ", 1.5), upper_" + n + ")\n";
+	}
+
+	return source;
+}
+
+template<typename Fn>
+double seconds(Fn fn)
+{
+	auto start = chrono::steady_clock::now();
+	fn();
+
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	size_t megabytes = argc > 1 ? stoul(argv[1]) : 8;
+	const int rounds = 5;
+
+	string source = make_source(megabytes << 20);
+	Arena arena;
+	SymbolTable symbols(arena);
+	Lexer lexer(source, symbols);
+	vector<Token> tokens;
+	double lex_time = seconds([&] { tokens = lexer.tokenize(); });
+
+	vector<string_view> words;
+
+	for (const auto& token : tokens)
+	{
+		if (token.type == TokenType::IDENTIFIER || classify_identifier(token.value) != TokenType::IDENTIFIER)
+			words.push_back(token.value);
+	}
+
+	for (const auto& word : words)
+	{
+		if (classify_linear(word) != classify_identifier(word))
+		{
+			cerr << "Mismatch on '" << word << "'" << endl;
+			return 1;
+		}
+	}
+
+	size_t checksum = 0;
+	double linear_time = seconds([&]
+	{
+		for (int r = 0; r < rounds; ++r)
+			for (const auto& word : words)
+				checksum += (size_t)classify_linear(word);
+	});
+	double hashed_time = seconds([&]
+	{
+		for (int r = 0; r < rounds; ++r)
+			for (const auto& word : words)
+				checksum += (size_t)classify_identifier(word);
+	});
+
+	double classified = (double)words.size() * rounds;
+
+	cout << "Source:            " << megabytes << " MB, " << tokens.size() << " tokens, " << words.size() << " identifiers / keywords" << endl;
+	cout << "Linear chain:      " << classified / linear_time / 1e6 << " M identifier tokens/sec" << endl;
+	cout << "Perfect hash:      " << classified / hashed_time / 1e6 << " M identifier tokens/sec" << endl;
+	cout << "Scanner:           " << scanner().name << " (set MINIPY_SCAN=scalar|sse2|avx2 to compare)" << endl;
+	cout << "Lexer (tokenize):  " << tokens.size() / lex_time / 1e6 << " M tokens/sec, " << symbols.size() << " distinct identifiers" << endl;
+	cout << "(checksum " << checksum << ")" << endl;
+
+	return 0;
+}
@@ -0,0 +1,129 @@
+//Print throughput benchmark: generated print code writing 10M lines through the runtime output buffer,
+//against printf and against flushing every line (--line-buffered)
+//Build: g++ -std=c++17 -O2 bench/print_bench.cpp -o print_bench
+//Needs a host C compiler ($CC or one on PATH); programs and their output go to the temp directory
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "../runtime.h"
+#include "../toolchain.h"
+
+using namespace std;
+
+//Each line is an int, a float and a string, as a minipy print(i, f, s) emits them
+const char* const BUFFERED_LOOP = R"C(
+    for (int i = 0; i < count; ++i)
+    {
+        MinipyText* line = minipy_print_begin();
+        minipy_text_put_int(line, i);
+        minipy_text_append(line, " ", sizeof(" ") - 1);
+        minipy_print_float(line, i * 0.5f);
+        minipy_text_append(line, " ", sizeof(" ") - 1);
+        minipy_print_string(line, label);
+        minipy_print_end(line);
+    }
+
+    minipy_flush();
+)C";
+
+//What print compiled to before the output runtime
+const char* const PRINTF_LOOP = R"C(
+    for (int i = 0; i < count; ++i)
+        printf("%d %f %.*s\n", i, i * 0.5f, label.length, string_data(label));
+)C";
+
+string make_program(const string& runtime, const char* loop, bool line_buffered, long long count)
+{
+	string code = runtime;
+	code += "\nint main(void)\n{\n";
+	code += "    int count = " + to_string(count) + ";\n";
+	code += "    String label = string_literal(\"line\");\n";
+
+	if (line_buffered)
+		code += "    minipy_output.line_buffered = 1;\n";
+
+	code += loop;
+	code += "    return 0;\n}\n";
+
+	return code;
+}
+
+template<typename Fn>
+double seconds(Fn fn)
+{
+	auto start = chrono::steady_clock::now();
+	fn();
+
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	long long count = argc > 1 ? stoll(argv[1]) : 10000000;
+
+	RuntimeFeatures features;
+	features.use_print({ VarType::INT });
+	features.use_print({ VarType::FLOAT });
+	features.use_print({ VarType::STRING });
+	string runtime = generate_runtime(features);
+
+	ToolchainOptions toolchain_options;
+	toolchain_options.optimization = 2;
+	unique_ptr<Toolchain> toolchain = find_toolchain(toolchain_options);
+	filesystem::path dir = filesystem::temp_directory_path();
+
+	struct Variant
+	{
+		const char* name;
+		const char* loop;
+		bool line_buffered;
+	};
+
+	const Variant variants[] = {
+		{ "printf", PRINTF_LOOP, false },
+		{ "output buffer", BUFFERED_LOOP, false },
+		{ "line-buffered", BUFFERED_LOOP, true },
+	};
+
+	cout << "Lines:          " << count << " per run, written to a file" << endl;
+
+	for (const auto& variant : variants)
+	{
+		string stem = (dir / ("print_bench_" + to_string(&variant - variants))).string();
+		string source = stem + ".c";
+		string executable = stem + toolchain->executable_extension();
+		string output = stem + ".txt";
+
+		ofstream(source) << make_program(runtime, variant.loop, variant.line_buffered, count);
+
+		if (system(toolchain->link_command(source, {}, executable).c_str()) != 0)
+		{
+			cerr << "Could Not Compile " << source << endl;
+			return 1;
+		}
+
+		string run = "\"" + executable + "\" > \"" + output + "\"";
+		int status = 0;
+		double time = seconds([&] { status = system(run.c_str()); });
+
+		if (status != 0)
+		{
+			cerr << "Run Failed: " << executable << endl;
+			return 1;
+		}
+
+		double megabytes = filesystem::file_size(output) / 1048576.0;
+
+		cout << left << setw(16) << string(variant.name) + ":" << count / time / 1e6 << " M lines/sec, "
+			<< megabytes / time << " MB/s (" << time << " s)" << endl;
+
+		filesystem::remove(source);
+		filesystem::remove(executable);
+		filesystem::remove(output);
+	}
+
+	return 0;
+}
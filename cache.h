@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+//---BUILD CACHE---
+//On-disk store of per-function translation units and their object files, named by content key.
+//Entries are never invalidated in place: any change to a function produces a new key.
+class BuildCache
+{
+private:
+	filesystem::path directory;
+
+public:
+	BuildCache(const string& dir) : directory(dir)
+	{
+		filesystem::create_directories(directory);
+	}
+
+	string source_path(uint64_t key) const
+	{
+		return (directory / ("fn_" + hex_key(key) + ".c")).string();
+	}
+
+	string object_path(uint64_t key, const string& extension) const
+	{
+		return (directory / ("fn_" + hex_key(key) + extension)).string();
+	}
+
+	bool has_source(uint64_t key) const
+	{
+		return filesystem::exists(source_path(key));
+	}
+
+	bool has_object(uint64_t key, const string& extension) const
+	{
+		return filesystem::exists(object_path(key, extension));
+	}
+
+	//Entries are written to a per-thread temporary and renamed into place, so an interrupted or
+	//concurrent build never leaves a partial entry
+	static string temp_path(const string& path)
+	{
+		return path + "." + to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+	}
+
+	void store_source(uint64_t key, const string& code) const
+	{
+		string path = source_path(key);
+		string temp = temp_path(path);
+
+		{
+			ofstream file(temp, ios::binary);
+
+			if (!file.is_open() || !(file << code))
+				throw runtime_error("Could Not Write Cache Entry " + temp);
+		}
+
+		filesystem::rename(temp, path);
+	}
+
+private:
+	static string hex_key(uint64_t key)
+	{
+		char text[17];
+		snprintf(text, sizeof(text), "%016llx", (unsigned long long)key);
+
+		return text;
+	}
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+//---EMITTER---
+//Streams generated C straight into an output sink, one line at a time
+class Emitter
+{
+private:
+	ostream& out;
+	int indent_level;
+	int own_temp_count;
+	int* temp_count;				//Shared with the emitter this one captures for
+
+public:
+	Emitter(ostream& o, int indent = 0) : out(o), indent_level(indent), own_temp_count(0), temp_count(&own_temp_count) {}
+
+	//Writes to a separate sink while continuing the parent's temporary numbering
+	Emitter(ostream& o, Emitter& parent, int indent) : out(o), indent_level(indent), own_temp_count(0), temp_count(parent.temp_count) {}
+
+	//Writes an indented line from its pieces without concatenating them first
+	template<typename... Parts>
+	void line(const Parts&... parts)
+	{
+		for (int i = 0; i < indent_level; ++i)
+			out << "    ";
+
+		(out << ... << parts);
+		out << '\n';
+	}
+
+	//Writes text exactly as given (preprocessor lines, pre-rendered blocks)
+	void raw(string_view text)
+	{
+		out << text;
+	}
+
+	void blank()
+	{
+		out << '\n';
+	}
+
+	void open_block()
+	{
+		line("{");
+		indent_level++;
+	}
+
+	void close_block()
+	{
+		indent_level--;
+		line("}");
+	}
+
+	void indent()
+	{
+		indent_level++;
+	}
+
+	void dedent()
+	{
+		indent_level--;
+	}
+
+	int depth() const
+	{
+		return indent_level;
+	}
+
+	//Next temporary name; numbering restarts per function so output depends only on the input
+	string temp(const char* prefix)
+	{
+		return string(prefix) + "_" + to_string(++*temp_count);
+	}
+
+	void reset_temps()
+	{
+		*temp_count = 0;
+	}
+};
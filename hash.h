@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+//---HASHING---
+//64-bit FNV-1a; stable across runs and platforms, so usable as an on-disk key
+struct Hasher
+{
+	uint64_t state = 14695981039346656037ull;
+
+	void add_byte(uint8_t byte)
+	{
+		state = (state ^ byte) * 1099511628211ull;
+	}
+
+	void add(uint64_t value)
+	{
+		for (int i = 0; i < 8; ++i)
+			add_byte((uint8_t)(value >> (i * 8)));
+	}
+
+	//Length-prefixed so adjacent strings cannot run together
+	void add(string_view text)
+	{
+		add((uint64_t)text.size());
+
+		for (char c : text)
+			add_byte((uint8_t)c);
+	}
+
+	uint64_t value() const
+	{
+		return state;
+	}
+};
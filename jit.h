@@ -0,0 +1,176 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "toolchain.h"
+
+#ifdef MINIPY_HAVE_LIBTCC
+#include <libtcc.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+using namespace std;
+
+//---JIT---
+//Compiles generated C into the running process and calls its entry point. With libtcc
+//(build with -DMINIPY_HAVE_LIBTCC -ltcc) the code is compiled straight from memory; otherwise
+//the host toolchain builds a shared library in a temporary directory, which is then loaded.
+const string JIT_ENTRY = "minipy_main";
+
+#ifdef _WIN32
+const string JIT_ENTRY_SIGNATURE = "__declspec(dllexport) int " + JIT_ENTRY + "()";
+#else
+const string JIT_ENTRY_SIGNATURE = "int " + JIT_ENTRY + "()";
+#endif
+
+class JitProgram
+{
+private:
+	typedef int (*EntryPoint)();
+
+#ifdef MINIPY_HAVE_LIBTCC
+	TCCState* state = nullptr;
+#else
+	void* library = nullptr;
+	filesystem::path temp_dir;
+#endif
+	EntryPoint entry = nullptr;
+
+public:
+#ifdef MINIPY_HAVE_LIBTCC
+	static const bool needs_toolchain = false;
+
+	JitProgram(const string& code, const Toolchain*)
+	{
+		state = tcc_new();
+
+		if (!state)
+			throw runtime_error("Could Not Create TCC State");
+
+		tcc_set_output_type(state, TCC_OUTPUT_MEMORY);
+
+		if (tcc_compile_string(state, code.c_str()) != 0 || tcc_relocate(state, TCC_RELOCATE_AUTO) < 0)
+		{
+			tcc_delete(state);
+			throw runtime_error("JIT Compilation Failed");
+		}
+
+		entry = (EntryPoint)tcc_get_symbol(state, JIT_ENTRY.c_str());
+
+		if (!entry)
+		{
+			tcc_delete(state);
+			throw runtime_error("JIT Entry Point Not Found");
+		}
+	}
+
+	~JitProgram()
+	{
+		tcc_delete(state);
+	}
+
+	const char* backend() const
+	{
+		return "libtcc";
+	}
+#else
+	static const bool needs_toolchain = true;
+
+	JitProgram(const string& code, const Toolchain* toolchain)
+	{
+		string unique = to_string(hash<thread::id>()(this_thread::get_id())) + "_" + to_string(chrono::steady_clock::now().time_since_epoch().count());
+		temp_dir = filesystem::temp_directory_path() / ("minipy_jit_" + unique);
+		filesystem::create_directories(temp_dir);
+
+		try
+		{
+			load(code, *toolchain);
+		}
+		catch (...)
+		{
+			unload();
+			throw;
+		}
+	}
+
+	~JitProgram()
+	{
+		unload();
+	}
+
+	const char* backend() const
+	{
+		return "shared library";
+	}
+#endif
+
+	JitProgram(const JitProgram&) = delete;
+	JitProgram& operator=(const JitProgram&) = delete;
+
+	int run() const
+	{
+		return entry();
+	}
+
+#ifndef MINIPY_HAVE_LIBTCC
+private:
+	void load(const string& code, const Toolchain& toolchain)
+	{
+		string source = (temp_dir / "program.c").string();
+		string path = (temp_dir / ("program" + toolchain.shared_library_extension())).string();
+
+		{
+			ofstream file(source, ios::binary);
+
+			if (!file.is_open() || !(file << code))
+				throw runtime_error("Could Not Write JIT Source " + source);
+		}
+
+		string command = toolchain.shared_library_command(source, path);
+
+		if (system(command.c_str()) != 0)
+			throw runtime_error("JIT Compilation Failed");
+
+#ifdef _WIN32
+		library = (void*)LoadLibraryA(path.c_str());
+#else
+		library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+
+		if (!library)
+			throw runtime_error("Could Not Load JIT Library " + path);
+
+#ifdef _WIN32
+		entry = (EntryPoint)GetProcAddress((HMODULE)library, JIT_ENTRY.c_str());
+#else
+		entry = (EntryPoint)dlsym(library, JIT_ENTRY.c_str());
+#endif
+
+		if (!entry)
+			throw runtime_error("JIT Entry Point Not Found");
+	}
+
+	void unload()
+	{
+		if (library)
+		{
+#ifdef _WIN32
+			FreeLibrary((HMODULE)library);
+#else
+			dlclose(library);
+#endif
+		}
+
+		error_code error;
+		filesystem::remove_all(temp_dir, error);
+	}
+#endif
+};
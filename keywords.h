@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "ASTNodes.h"
+
+using namespace std;
+
+//---KEYWORDS---
+struct Keyword
+{
+	string_view text;
+	TokenType type = TokenType::IDENTIFIER;
+};
+
+constexpr Keyword keyword_list[] =
+{
+	{ "def", TokenType::DEF }, { "return", TokenType::RETURN }, { "print", TokenType::PRINT },
+	{ "int", TokenType::INT }, { "float", TokenType::FLOAT }, { "string", TokenType::STRING }, { "bool", TokenType::BOOL },
+	{ "list", TokenType::LIST }, { "tuple", TokenType::TUPLE }, { "dict", TokenType::DICT },
+	{ "if", TokenType::IF }, { "elif", TokenType::ELIF }, { "else", TokenType::ELSE },
+	{ "for", TokenType::FOR }, { "in", TokenType::IN }, { "range", TokenType::RANGE }, { "while", TokenType::WHILE },
+	{ "match", TokenType::MATCH }, { "case", TokenType::CASE },
+	{ "true", TokenType::TRUE }, { "false", TokenType::FALSE },
+	{ "and", TokenType::AND }, { "or", TokenType::OR }, { "not", TokenType::NOT },
+	{ "sep", TokenType::SEP }, { "len", TokenType::LEN },
+	{ "append", TokenType::CALL_METHOD }, { "upper", TokenType::CALL_METHOD }, { "lower", TokenType::CALL_METHOD },
+	{ "strip", TokenType::CALL_METHOD }, { "replace", TokenType::CALL_METHOD }, { "split", TokenType::CALL_METHOD },
+	{ "find", TokenType::CALL_METHOD }
+};
+
+constexpr size_t KEYWORD_MIN_LENGTH = 2;
+constexpr size_t KEYWORD_MAX_LENGTH = 7;
+
+//Multiplicative hash of (length, first, second, last char); the seed was searched offline for zero collisions
+constexpr uint32_t KEYWORD_SEED = 0x597ca1bb;
+constexpr int KEYWORD_BITS = 6;
+
+constexpr size_t keyword_slot(const char* s, size_t length)
+{
+	uint32_t key = (uint32_t)(uint8_t)s[0] | (uint32_t)(uint8_t)s[1] << 8 |
+		(uint32_t)(uint8_t)s[length - 1] << 16 | (uint32_t)length << 24;
+
+	return (uint32_t)(key * KEYWORD_SEED) >> (32 - KEYWORD_BITS);
+}
+
+struct KeywordTable
+{
+	Keyword slots[1 << KEYWORD_BITS];
+	bool perfect;
+};
+
+constexpr KeywordTable build_keyword_table()
+{
+	KeywordTable table{};
+	table.perfect = true;
+
+	for (const auto& keyword : keyword_list)
+	{
+		Keyword& slot = table.slots[keyword_slot(keyword.text.data(), keyword.text.size())];
+
+		if (!slot.text.empty() || keyword.text.size() < KEYWORD_MIN_LENGTH || keyword.text.size() > KEYWORD_MAX_LENGTH)
+			table.perfect = false;
+
+		slot = keyword;
+	}
+
+	return table;
+}
+
+constexpr KeywordTable keyword_table = build_keyword_table();
+
+static_assert(keyword_table.perfect, "Keyword hash collision: search for a new KEYWORD_SEED");
+
+//Classifies an identifier with one table probe and at most one memcmp
+inline TokenType classify_identifier(string_view value)
+{
+	if (value.size() < KEYWORD_MIN_LENGTH || value.size() > KEYWORD_MAX_LENGTH)
+		return TokenType::IDENTIFIER;
+
+	const Keyword& keyword = keyword_table.slots[keyword_slot(value.data(), value.size())];
+
+	if (keyword.text.size() == value.size() && memcmp(keyword.text.data(), value.data(), value.size()) == 0)
+		return keyword.type;
+
+	return TokenType::IDENTIFIER;
+}
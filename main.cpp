@@ -1,117 +1,592 @@
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <string>
-#include <memory>
-#include <stdexcept>
-#include "lexer.h"
-#include "Parser.h"
-
-//---MAIN---
-int main(int argc, char* argv[])
-{
-	//Check for Input
-	if (argc != 2)
-	{
-		cerr << "Usage: " << argv[0] << " <input.minipy>" << endl;
-		return 1;
-	}
-
-	//Read MiniPy Source File
-	string input_file = argv[1];
-	ifstream file(input_file);
-
-	if (!file.is_open())
-	{
-		cerr << "Error: Could not open input file " << input_file << endl;
-		return 1;
-	}
-
-	string source((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
-
-	file.close();
-
-	try
-	{
-		//---Lexer---
-		Lexer lexer(source);
-		vector<Token> tokens = lexer.tokenize();
-
-		//---Parser---
-		Parser parser(tokens);
-		vector<unique_ptr<ASTNode>> ast = parser.parse_program();
-
-		//---Code Generator---
-		vector<string> gc_strings;
-		string c_code;
-
-		//Function Definitions
-		for (const auto& node : ast)
-		{
-			if (dynamic_cast<FunctionNode*>(node.get()))
-				c_code += node->generate_c_code(gc_strings) + "\n";
-		}
-
-		//Create main()
-		c_code += "int main()\n{\n";
-
-		for (const auto& node : ast)
-		{
-			if (!dynamic_cast<FunctionNode*>(node.get()))
-				c_code += "    " + node->generate_c_code(gc_strings) + "\n";
-		}
-
-		//Cleanup
-		for (const auto& var : gc_strings)
-		{
-			auto it = parser.get_variables().find(var);
-
-			if (it != parser.get_variables().end())
-			{
-				CollectionType type = it->second;
-
-				if (type.base_type == VarType::STRING)
-					c_code += "    free_string(" + var + ");\n";
-				else if (type.base_type == VarType::LIST)
-					c_code += "    free_list_" + Parser::vartype_to_c(type.element_type) + "(" + var + ");\n";
-				else if (type.base_type == VarType::TUPLE)
-					c_code += "    free_tuple_" + Parser::vartype_to_c(type.element_type) + "(" + var + ");\n";
-				else if (type.base_type == VarType::DICT)
-					c_code += "    free_dict_string_" + Parser::vartype_to_c(type.value_type) + "(" + var + ");\n";
-			}
-		}
-
-		c_code += "    return 0;\n}\n";
-
-		//Write Code to File
-		ofstream out_file("output.c");
-
-		if (!out_file.is_open())
-		{
-			cerr << "Error: Could not open output file 'output.c'" << endl;
-			return 1;
-		}
-
-		out_file << c_code;
-		out_file.close();
-
-		//Compile
-		string compile_command = "\"C:\\Program Files (x86)\\Microsoft Visual Studio 14.0\\VC\\bin\\cl.exe\" output.c /Feoutput.exe";
-		int result = system(compile_command.c_str());
-
-		if (result != 0)
-		{
-			cerr << "Error: Compilation Failed" << endl;
-			return 1;
-		}
-
-		cout << "Compilation Successful.\nExecutable: output.exe" << endl;
-	}
-	catch (const exception& e)
-	{
-		cerr << "Error: " << e.what() << endl;
-		return 1;
-	}
-
-	return 0;
-}
\ No newline at end of file
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include "session.h"
+#include "lexer.h"
+#include "parser.h"
+#include "cache.h"
+#include "parallel.h"
+#include "scheduler.h"
+#include "toolchain.h"
+#include "jit.h"
+
+//---BUILD---
+//Bump whenever code generation changes so stale cache entries are never reused
+const uint64_t CODEGEN_VERSION = 17;
+
+//Settings shared by single-file and batch builds
+struct BuildOptions
+{
+	const Toolchain* toolchain = nullptr;
+	string cache_dir;					//Empty: one translation unit, no cache
+	unsigned threads = 1;
+	bool show_stats = false;
+	bool line_buffered = false;			//Flush program output after every line
+};
+
+//Generated C for one input, ready for the host compiler
+struct GeneratedProgram
+{
+	string c_file;
+	string executable;
+	vector<string> units;				//Per-function sources still to be compiled
+	vector<string> unit_objects;		//Object file for each entry of units
+	vector<string> objects;				//Everything linked together with c_file
+	size_t functions = 0;
+	size_t reused = 0;
+};
+
+struct FileTiming
+{
+	double parse = 0;
+	double codegen = 0;
+	double compile = 0;
+};
+
+double elapsed_ms(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+//Emits the entry point (main() unless loaded in-process) from the module-level statements.
+//The runtime prelude is emitted separately, ahead of every function.
+void generate_main(Emitter& out, const Block& ast, bool line_buffered, const string& entry = "int main()")
+{
+	out.reset_temps();
+	out.line(entry);
+	out.open_block();
+
+	if (line_buffered)
+		out.line("minipy_output.line_buffered = 1;");
+
+	for (const auto& node : ast.statements)
+	{
+		if (dynamic_cast<FunctionNode*>(node) || dynamic_cast<HelperNode*>(node))
+			continue;
+
+		generate_statement(out, *node);
+	}
+
+	//Module variables are released when main() ends
+	free_locals(out, ast.owned);
+	out.line("minipy_flush();");
+	out.line("return 0;");
+	out.close_block();
+}
+
+vector<const FunctionNode*> collect_functions(const Block& ast)
+{
+	vector<const FunctionNode*> functions;
+
+	for (const auto& node : ast.statements)
+	{
+		if (auto function = dynamic_cast<FunctionNode*>(node))
+			functions.push_back(function);
+	}
+
+	return functions;
+}
+
+//Writes every function in source order. A single thread generates straight into the output. Function
+//bodies share no codegen state, so with more threads each is emitted into its own buffer on the pool
+//and written as soon as all those before it have been; only ones finished out of order wait in memory
+void generate_functions(Emitter& out, const vector<const FunctionNode*>& functions, unsigned threads)
+{
+	if (threads <= 1)
+	{
+		for (const auto* function : functions)
+			generate_statement(out, *function);
+
+		return;
+	}
+
+	vector<string> code(functions.size());
+	vector<bool> done(functions.size(), false);
+	size_t written = 0;
+	mutex write_lock;
+
+	parallel_for(functions.size(), threads, [&](size_t i)
+	{
+		ostringstream buffer;
+		Emitter function_out(buffer);
+		generate_statement(function_out, *functions[i]);
+
+		lock_guard<mutex> guard(write_lock);
+		code[i] = buffer.str();
+		done[i] = true;
+
+		for (; written < functions.size() && done[written]; ++written)
+		{
+			out.raw(code[written]);
+			string().swap(code[written]);
+		}
+	});
+}
+
+//The runtime generated for the program, which every translation unit starts with
+string runtime_prelude(const Block& ast)
+{
+	string prelude;
+
+	for (const auto& node : ast.statements)
+	{
+		if (auto helper = dynamic_cast<HelperNode*>(node))
+			prelude.append(helper->code);
+	}
+
+	return prelude;
+}
+
+//Single translation unit: runtime, every function, then the entry point
+void generate_whole(Emitter& out, const Block& ast, const BuildOptions& options, const string& entry = "int main()")
+{
+	out.raw(runtime_prelude(ast));
+	out.blank();
+
+	//Function Definitions, in source order
+	generate_functions(out, collect_functions(ast), options.threads);
+
+	generate_main(out, ast, options.line_buffered, entry);
+}
+
+void write_whole(const Block& ast, GeneratedProgram& program, const BuildOptions& options)
+{
+	ofstream out_file(program.c_file);
+
+	if (!out_file.is_open())
+		throw runtime_error("Could Not Open Output File " + program.c_file);
+
+	Emitter out(out_file);
+	generate_whole(out, ast, options);
+}
+
+//One translation unit and object file per function, reused from the cache while its key is unchanged.
+//Each unit carries only the runtime its own function needs, so using a new type elsewhere in the program
+//does not invalidate it. The main file holds the full runtime, prototypes and main().
+void write_incremental(const Block& ast, const BuildCache& cache, const Toolchain& toolchain, GeneratedProgram& program, const BuildOptions& options)
+{
+	string prelude = runtime_prelude(ast);
+	vector<const FunctionNode*> functions = collect_functions(ast);
+	map<string_view, const FunctionNode*> by_name;
+
+	for (const auto& function : functions)
+		by_name[function->name] = function;
+
+	//A function's runtime follows from its tokens and callee signatures, which its cache key already covers
+	Hasher unit_hash;
+	unit_hash.add(CODEGEN_VERSION);
+	unit_hash.add(toolchain.fingerprint());
+
+	vector<uint64_t> keys(functions.size());
+	atomic<size_t> reused(0);
+
+	//Units missing from the cache are generated in parallel
+	parallel_for(functions.size(), options.threads, [&](size_t i)
+	{
+		const FunctionNode* function = functions[i];
+		Hasher key_hash = unit_hash;
+		key_hash.add(function->cache_key);
+		keys[i] = key_hash.value();
+
+		if (cache.has_source(keys[i]))
+		{
+			reused++;
+			return;
+		}
+
+		ostringstream unit;
+		Emitter out(unit);
+
+		out.raw(generate_runtime(function->runtime));
+
+		for (const auto& callee : function->callees)
+		{
+			if (callee != function->name)
+				out.line(by_name.at(callee)->signature(), ";");
+		}
+
+		out.blank();
+		generate_statement(out, *function);
+		cache.store_source(keys[i], unit.str());
+	});
+
+	for (uint64_t key : keys)
+	{
+		string object = cache.object_path(key, toolchain.object_extension());
+
+		if (!cache.has_object(key, toolchain.object_extension()))
+		{
+			program.units.push_back(cache.source_path(key));
+			program.unit_objects.push_back(object);
+		}
+
+		program.objects.push_back(object);
+	}
+
+	program.functions = functions.size();
+	program.reused = reused;
+
+	ofstream out_file(program.c_file);
+
+	if (!out_file.is_open())
+		throw runtime_error("Could Not Open Output File " + program.c_file);
+
+	Emitter out(out_file);
+
+	out.raw(prelude);
+
+	for (const auto& function : functions)
+		out.line(function->signature(), ";");
+
+	out.blank();
+	generate_main(out, ast, options.line_buffered);
+}
+
+//Compiles outstanding function units, then the main file, linking in every object
+bool compile_program(const GeneratedProgram& program, const Toolchain& toolchain)
+{
+	//Objects go into the cache, so like its sources they only appear once complete
+	for (size_t i = 0; i < program.units.size(); ++i)
+	{
+		string temp_object = BuildCache::temp_path(program.unit_objects[i]);
+		string compile_command = toolchain.compile_command(program.units[i], temp_object);
+
+		error_code error;
+
+		if (system(compile_command.c_str()) != 0)
+		{
+			filesystem::remove(temp_object, error);
+			return false;
+		}
+
+		filesystem::rename(temp_object, program.unit_objects[i], error);
+
+		if (error)
+		{
+			filesystem::remove(temp_object, error);
+			return false;
+		}
+	}
+
+	string link_command = toolchain.link_command(program.c_file, program.objects, program.executable);
+
+	return system(link_command.c_str()) == 0;
+}
+
+//The AST lives in the session's arena, so it must not outlive the session
+Block parse_file(Session& session, const string& input, const BuildOptions& options, FileTiming& timing)
+{
+	if (!session.source.is_open())
+		throw runtime_error("Could Not Open Input File " + input);
+
+	//---Lexer / Parser---
+	//Tokens are pulled on demand, so lexing is interleaved with parsing
+	auto start = chrono::steady_clock::now();
+	Lexer lexer(session.source.text(), session.symbols);
+	Parser parser(lexer, session.arena, session.symbols);
+	Block ast = parser.parse_program();
+	timing.parse = elapsed_ms(start);
+
+	if (options.show_stats)
+	{
+		const Arena::Stats& stats = session.arena.get_stats();
+
+		cout << "Arena: " << stats.allocations << " allocations, " << stats.bytes_used << " bytes used, "
+			<< stats.blocks << " blocks (" << stats.bytes_reserved << " bytes) from malloc" << endl;
+	}
+
+	return ast;
+}
+
+//Lexes, parses and generates C for one input; the session and its AST are released on return
+GeneratedProgram generate_file(const string& input, const string& c_file, const string& executable, const BuildOptions& options, FileTiming& timing)
+{
+	Session session(input);
+	Block ast = parse_file(session, input, options, timing);
+
+	//---Code Generator---
+	auto start = chrono::steady_clock::now();
+	GeneratedProgram program;
+	program.c_file = c_file;
+	program.executable = executable;
+
+	if (options.cache_dir.empty())
+		write_whole(ast, program, options);
+	else
+		write_incremental(ast, BuildCache(options.cache_dir), *options.toolchain, program, options);
+
+	timing.codegen = elapsed_ms(start);
+
+	return program;
+}
+
+//Compiles one input into the running process and calls its entry point. Program output goes to
+//stdout as usual; the timing line goes to stderr so it never mixes with it.
+int run_jit(const string& input, const BuildOptions& options)
+{
+	Session session(input);
+	FileTiming timing;
+	Block ast = parse_file(session, input, options, timing);
+
+	auto start = chrono::steady_clock::now();
+	ostringstream code;
+	Emitter out(code);
+	generate_whole(out, ast, options, JIT_ENTRY_SIGNATURE);
+	timing.codegen = elapsed_ms(start);
+
+	start = chrono::steady_clock::now();
+	JitProgram program(code.str(), options.toolchain);
+	timing.compile = elapsed_ms(start);
+
+	start = chrono::steady_clock::now();
+	int status = program.run();
+	fflush(stdout);
+	double run = elapsed_ms(start);
+
+	cerr << fixed << setprecision(1) << "JIT (" << program.backend() << "): parse " << timing.parse << " ms, codegen "
+		<< timing.codegen << " ms, compile " << timing.compile << " ms, run " << run << " ms" << endl;
+
+	return status;
+}
+
+//Inputs named by a directory (every .minipy below it) or a list file (one path per line)
+vector<string> batch_inputs(const string& source)
+{
+	vector<string> inputs;
+
+	if (filesystem::is_directory(source))
+	{
+		for (const auto& entry : filesystem::recursive_directory_iterator(source))
+		{
+			if (entry.is_regular_file() && entry.path().extension() == ".minipy")
+				inputs.push_back(entry.path().string());
+		}
+
+		sort(inputs.begin(), inputs.end());
+
+		return inputs;
+	}
+
+	ifstream list(source);
+
+	if (!list.is_open())
+		throw runtime_error("Could Not Open Batch List " + source);
+
+	string line;
+
+	while (getline(list, line))
+	{
+		line.erase(line.find_last_not_of(" \t\r") + 1);
+
+		if (!line.empty())
+			inputs.push_back(line);
+	}
+
+	return inputs;
+}
+
+//Builds every input on a work-stealing pool. Each file's front end is one task and its host
+//compile a follow-up task, so idle workers pick up compiles while others are still parsing.
+//Outputs sit next to each input: name.minipy -> name.c and the executable name.
+int run_batch(const string& source, const BuildOptions& options, unsigned compile_jobs)
+{
+	struct FileResult
+	{
+		GeneratedProgram program;
+		FileTiming timing;
+		string error;
+	};
+
+	vector<string> inputs = batch_inputs(source);
+	vector<FileResult> results(inputs.size());
+	BuildOptions file_options = options;
+	file_options.threads = 1;			//Files are the unit of parallelism
+	file_options.show_stats = false;
+
+	auto start = chrono::steady_clock::now();
+
+	{
+		WorkStealingPool pool(options.threads);
+		JobLimit compiler_jobs(compile_jobs);
+
+		for (size_t i = 0; i < inputs.size(); ++i)
+		{
+			pool.submit([&, i]
+			{
+				FileResult& result = results[i];
+				string stem = filesystem::path(inputs[i]).replace_extension().string();
+
+				try
+				{
+					result.program = generate_file(inputs[i], stem + ".c", stem + options.toolchain->executable_extension(), file_options, result.timing);
+				}
+				catch (const exception& e)
+				{
+					result.error = e.what();
+					return;
+				}
+
+				pool.submit([&, i]
+				{
+					FileResult& result = results[i];
+					auto compile_start = chrono::steady_clock::now();
+					bool compiled;
+
+					{
+						JobSlot slot(compiler_jobs);
+						compiled = compile_program(result.program, *options.toolchain);
+					}
+
+					result.timing.compile = elapsed_ms(compile_start);
+
+					if (!compiled)
+						result.error = "Compilation Failed";
+				});
+			});
+		}
+
+		pool.wait();
+	}
+
+	double total = elapsed_ms(start);
+	size_t failed = 0;
+
+	cout << fixed << setprecision(1);
+	cout << setw(10) << "parse ms" << setw(12) << "codegen ms" << setw(12) << "compile ms" << "  file" << endl;
+
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		const FileResult& result = results[i];
+
+		cout << setw(10) << result.timing.parse << setw(12) << result.timing.codegen << setw(12) << result.timing.compile << "  " << inputs[i];
+
+		if (!result.error.empty())
+		{
+			cout << "  (" << result.error << ")";
+			failed++;
+		}
+
+		cout << endl;
+	}
+
+	cout << inputs.size() - failed << " of " << inputs.size() << " files built in " << total << " ms ("
+		<< options.threads << " threads, " << compile_jobs << " compile jobs)" << endl;
+
+	return failed == 0 ? 0 : 1;
+}
+
+//---MAIN---
+int main(int argc, char* argv[])
+{
+	//Check for Input
+	string input_file;
+	string batch_source;
+	string executable;
+	BuildOptions options;
+	ToolchainOptions toolchain_options;
+	options.threads = default_thread_count();
+	unsigned compile_jobs = 0;
+	bool run_program = false;
+	bool usage_error = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		string arg = argv[i];
+
+		if (arg == "--stats")
+			options.show_stats = true;
+		else if (arg == "--line-buffered")
+			options.line_buffered = true;
+		else if (arg == "--run")
+			run_program = true;
+		else if (arg == "--incremental")
+			options.cache_dir = options.cache_dir.empty() ? ".minipy_cache" : options.cache_dir;
+		else if (arg == "--cache-dir" && i + 1 < argc)
+			options.cache_dir = argv[++i];
+		else if (arg == "-j" && i + 1 < argc)
+			options.threads = max(1, atoi(argv[++i]));
+		else if (arg == "--batch" && i + 1 < argc)
+			batch_source = argv[++i];
+		else if (arg == "--compile-jobs" && i + 1 < argc)
+			compile_jobs = max(1, atoi(argv[++i]));
+		else if (arg == "-O0" || arg == "-O2" || arg == "-O3")
+			toolchain_options.optimization = arg[2] - '0';
+		else if (arg == "-march=native")
+			toolchain_options.native_arch = true;
+		else if (arg == "-flto")
+			toolchain_options.lto = true;
+		else if (arg == "--cc" && i + 1 < argc)
+			toolchain_options.compiler = argv[++i];
+		else if (arg == "-o" && i + 1 < argc)
+			executable = argv[++i];
+		else if (input_file.empty())
+			input_file = arg;
+		else
+			usage_error = true;			//More than one input
+	}
+
+	//Batch outputs are named after each input, so -o only applies to a single file. --run writes no files at all.
+	if (!batch_source.empty() && (!executable.empty() || run_program))
+		usage_error = true;
+
+	if (run_program && (!executable.empty() || !options.cache_dir.empty()))
+		usage_error = true;
+
+	if (input_file.empty() == batch_source.empty() || usage_error)
+	{
+		cerr << "Usage: " << argv[0] << " [options] [-o <executable>] <input.minipy>" << endl;
+		cerr << "       " << argv[0] << " [options] --run <input.minipy>" << endl;
+		cerr << "       " << argv[0] << " [options] --batch <directory|list file> [--compile-jobs <n>]" << endl;
+		cerr << "Options: [-O0|-O2|-O3] [-march=native] [-flto] [--cc <compiler>] [--stats] [--line-buffered] [--incremental] [--cache-dir <dir>] [-j <threads>]" << endl;
+		return 1;
+	}
+
+	try
+	{
+		unique_ptr<Toolchain> toolchain;
+
+		if (!run_program || JitProgram::needs_toolchain)
+			toolchain = find_toolchain(toolchain_options);
+
+		options.toolchain = toolchain.get();
+
+		if (run_program)
+			return run_jit(input_file, options);
+
+		if (executable.empty())
+			executable = "output" + toolchain->executable_extension();
+
+		if (!batch_source.empty())
+			return run_batch(batch_source, options, compile_jobs ? compile_jobs : options.threads);
+
+		FileTiming timing;
+		GeneratedProgram program = generate_file(input_file, "output.c", executable, options, timing);
+
+		if (!options.cache_dir.empty())
+			cout << "Cache: " << program.reused << " of " << program.functions << " functions reused, " << program.units.size() << " to compile" << endl;
+
+		//---Compile---
+		if (!compile_program(program, *toolchain))
+		{
+			cerr << "Error: Compilation Failed" << endl;
+			return 1;
+		}
+
+		cout << "Compilation Successful.\nExecutable: " << executable << endl;
+	}
+	catch (const exception& e)
+	{
+		cerr << "Error: " << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//---PARALLEL---
+inline unsigned default_thread_count()
+{
+	unsigned count = thread::hardware_concurrency();
+
+	return count ? count : 1;
+}
+
+//Runs body(i) for every i in [0, count) on up to `threads` threads. Indices are claimed one at a
+//time from a shared counter, so uneven items balance themselves. The first exception is rethrown.
+template<typename Body>
+void parallel_for(size_t count, unsigned threads, Body body)
+{
+	size_t workers = min((size_t)threads, count);
+
+	if (workers <= 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+			body(i);
+
+		return;
+	}
+
+	atomic<size_t> next(0);
+	atomic<bool> failed(false);
+	exception_ptr error;
+	mutex error_lock;
+
+	auto work = [&]
+	{
+		for (size_t i = next++; i < count && !failed; i = next++)
+		{
+			try
+			{
+				body(i);
+			}
+			catch (...)
+			{
+				lock_guard<mutex> guard(error_lock);
+
+				if (!error)
+					error = current_exception();
+
+				failed = true;
+			}
+		}
+	};
+
+	vector<thread> pool;
+
+	for (size_t i = 1; i < workers; ++i)
+		pool.emplace_back(work);
+
+	work();
+
+	for (auto& worker : pool)
+		worker.join();
+
+	if (error)
+		rethrow_exception(error);
+}
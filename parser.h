@@ -1,1402 +1,1322 @@
-#pragma once
-#include <vector>
-#include <string>
-#include <memory>
-#include <stdexcept>
-#include <map>
-#include <set>
-#include <sstream>
-#include "ASTNodes.h"
-
-using namespace std;
-
-//---GLOBALS---
-//Token Types
-enum class TokenType
-{
-	DEF, RETURN, PRINT, CALL_METHOD,
-	INT, FLOAT, STRING, BOOL, LIST, TUPLE, DICT,
-	AND, OR, NOT, TRUE, FALSE,
-	IF, ELIF, ELSE, FOR, WHILE, IN, RANGE, MATCH, CASE,
-	IDENTIFIER, NUMBER, FLOATING, STRING_LITERAL,
-	FSTRING_START, FSTRING_END, FSTRING_EXPR_START, FSTRING_EXPR_END, FSTRING_FORMAT_SPEC, ALIGNMENT,
-	COLON, COMMA, SEP, DOT, LEN,
-	EQUALS, EQ, NOTEQ, GREATER, LESSER, GREATEREQ, LESSEREQ,
-	PLUS, MINUS, MULT, DIV,
-	LPAREN, RPAREN, LBRACKET, RBRACKET, LBRACE, RBRACE,
-	INDENT, DEDENT,
-	NEWLINE, EOF_TOKEN
-};
-
-//Token Structure
-struct Token
-{
-	TokenType type;
-	string value;
-	int line;
-};
-
-//Variable Type
-enum class VarType
-{
-	INT, FLOAT, STRING, BOOL, LIST, TUPLE, DICT, NONE
-};
-
-//Collection Type
-struct CollectionType
-{
-	VarType base_type;
-	VarType element_type;
-	VarType key_type;
-	VarType value_type;
-};
-
-//---PARSER---
-class Parser
-{
-private:
-	vector<Token> tokens;
-	size_t pos;
-	map<string, CollectionType> variables;
-	map<string, pair<vector<CollectionType>, CollectionType>> functions;
-	int string_temp_counter;
-	CollectionType expr_type;
-	set<string> helper_includes;
-
-	struct FormatSpec
-	{
-		string alignment;
-		string width;
-		string precision;
-		char type;
-	};
-
-public:
-	Parser(const vector<Token>& t) : tokens(t), pos(0), string_temp_counter(0)
-	{
-		helper_includes.insert("common.h");		//Always include common.h for standard includes
-	}
-
-	vector<unique_ptr<ASTNode>> parse_program()
-	{
-		vector<unique_ptr<ASTNode>> program;
-
-		string include_code;
-
-		for (const auto& include : helper_includes)
-			include_code += "#include \"" + include + "\"\n";
-
-		program.push_back(make_unique<HelperNode>(include_code));
-
-		while (tokens[pos].type != TokenType::EOF_TOKEN)
-			program.push_back(parse_statement());
-
-		return program;
-	}
-
-	static string vartype_to_c(VarType type)
-	{
-		switch (type)
-		{
-		case VarType::INT:
-			return "int";
-		case VarType::FLOAT:
-			return "float";
-		case VarType::STRING:
-			return "string";
-		case VarType::BOOL:
-			return "bool";
-		case VarType::LIST:
-			return "list";
-		case VarType::TUPLE:
-			return "tuple";
-		case VarType::DICT:
-			return "dict";
-		default:
-			return "void";
-		}
-	}
-
-	const map<string, CollectionType>& get_variables() const
-	{
-		return variables;		//Exposes variables map
-	}
-
-private:
-	CollectionType token_to_vartype(TokenType type)
-	{
-		if (type == TokenType::INT)
-			return{ VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE };
-
-		if (type == TokenType::FLOAT)
-			return{ VarType::FLOAT, VarType::NONE, VarType::NONE, VarType::NONE };
-
-		if (type == TokenType::STRING)
-			return{ VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE };
-
-		if (type == TokenType::BOOL)
-			return{ VarType::BOOL, VarType::NONE, VarType::NONE, VarType::NONE };
-
-		throw runtime_error("Invalid Type at Line " + to_string(tokens[pos].line));
-	}
-
-	Token expect(TokenType type)
-	{
-		if (pos >= tokens.size() || tokens[pos].type != type)
-			throw runtime_error("Unexpected Token Type at Line " + to_string(tokens[pos].line));
-
-		return tokens[pos++];
-	}
-
-	CollectionType parse_collection_type()
-	{
-		CollectionType result;
-
-		if (tokens[pos].type == TokenType::LIST)
-		{
-			expect(TokenType::LIST);
-			expect(TokenType::LBRACKET);
-
-			result.base_type = VarType::LIST;
-			result.element_type = token_to_vartype(tokens[pos].type).base_type;
-
-			expect(tokens[pos].type);
-			expect(TokenType::RBRACKET);
-
-			helper_includes.insert("list_" + vartype_to_c(result.element_type) + ".h");
-		}
-		else if (tokens[pos].type == TokenType::TUPLE)
-		{
-			expect(TokenType::TUPLE);
-			expect(TokenType::LBRACKET);
-
-			result.base_type = VarType::TUPLE;
-			result.element_type = token_to_vartype(tokens[pos].type).base_type;
-
-			expect(tokens[pos].type);
-			expect(TokenType::RBRACKET);
-
-			helper_includes.insert("tuple_" + vartype_to_c(result.element_type) + ".h");
-		}
-		else if (tokens[pos].type == TokenType::DICT)
-		{
-			expect(TokenType::DICT);
-			expect(TokenType::LBRACKET);
-
-			result.base_type = VarType::DICT;
-			result.key_type = token_to_vartype(tokens[pos].type).base_type;
-
-			if (result.key_type != VarType::STRING)
-				throw runtime_error("Dictionary Keys Must be Strings at Line " + to_string(tokens[pos].line));
-
-			expect(TokenType::STRING);
-			expect(TokenType::COMMA);
-
-			result.value_type = token_to_vartype(tokens[pos].type).base_type;
-
-			expect(tokens[pos].type);
-			expect(TokenType::RBRACKET);
-
-			helper_includes.insert("dict_string_" + vartype_to_c(result.value_type) + ".h");
-		}
-		else
-		{
-			result = token_to_vartype(tokens[pos].type);
-
-			if (result.base_type == VarType::STRING)
-				helper_includes.insert("string_utils.h");
-		}
-
-		return result;
-	}
-
-	unique_ptr<ASTNode> parse_statement()
-	{
-		if (tokens[pos].type == TokenType::DEF)
-			return parse_function();
-		else if (tokens[pos].type == TokenType::RETURN)
-			return parse_return();
-		else if (tokens[pos].type == TokenType::PRINT)
-			return parse_print();
-		else if (tokens[pos].type == TokenType::IF)
-			return parse_if();
-		else if (tokens[pos].type == TokenType::FOR)
-			return parse_for();
-		else if (tokens[pos].type == TokenType::WHILE)
-			return parse_while();
-		else if (tokens[pos].type == TokenType::MATCH)
-			return parse_match();
-		else if (tokens[pos].type == TokenType::INT || tokens[pos].type == TokenType::FLOAT ||
-			tokens[pos].type == TokenType::STRING || tokens[pos].type == TokenType::BOOL ||
-			tokens[pos].type == TokenType::LIST || tokens[pos].type == TokenType::TUPLE ||
-			tokens[pos].type == TokenType::DICT)
-			return parse_assignment();
-		else if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos + 1].type == TokenType::LPAREN)
-			return parse_function_call();
-		else if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos + 1].type == TokenType::DOT)
-			return parse_method_call();
-		else if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos + 1].type == TokenType::LBRACKET)
-			return parse_index_assignment();
-		else
-			throw runtime_error("Unexpected Token at Line " + to_string(tokens[pos].line));
-	}
-
-	pair<string, VarType> parse_expression()
-	{
-		string result;
-		VarType type = VarType::NONE;
-
-		if (tokens[pos].type == TokenType::NUMBER)
-		{
-			result = expect(TokenType::NUMBER).value;
-			type = VarType::INT;
-			expr_type = { VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE };
-		}
-		else if (tokens[pos].type == TokenType::FLOATING)
-		{
-			result = expect(TokenType::FLOATING).value;
-			type = VarType::FLOAT;
-			expr_type = { VarType::FLOAT, VarType::NONE, VarType::NONE, VarType::NONE };
-		}
-		else if (tokens[pos].type == TokenType::STRING_LITERAL)
-		{
-			result = "\"" + expect(TokenType::STRING_LITERAL).value + "\"";
-			type = VarType::STRING;
-			expr_type = { VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE };
-			helper_includes.insert("string_utils.h");
-		}
-		else if (tokens[pos].type == TokenType::TRUE || tokens[pos].type == TokenType::FALSE)
-		{
-			result = expect(tokens[pos].type).value;
-			type = VarType::BOOL;
-			expr_type = { VarType::BOOL, VarType::NONE, VarType::NONE, VarType::NONE };
-		}
-		else if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos + 1].type == TokenType::LPAREN)
-		{
-			string func_name = expect(TokenType::IDENTIFIER).value;
-			expect(TokenType::LPAREN);
-			vector<string> args;
-
-			if (tokens[pos].type != TokenType::RPAREN)
-			{
-				auto expr = parse_expression();
-				args.push_back(expr.first);
-
-				while (tokens[pos].type == TokenType::COMMA)
-				{
-					expect(TokenType::COMMA);
-
-					expr = parse_expression();
-					args.push_back(expr.first);
-				}
-			}
-
-			expect(TokenType::RPAREN);
-
-			if (functions.find(func_name) == functions.end())
-				throw runtime_error("Undefined function " + func_name + " at line " + to_string(tokens[pos].line));
-
-			result = func_name + "(";
-
-			for (size_t i = 0; i < args.size(); ++i)
-			{
-				result += args[i];
-
-				if (i < args.size() - 1)
-					result += ", ";
-			}
-
-			result += ")";
-			type = functions[func_name].second.base_type;
-			expr_type = functions[func_name].second;
-		}
-		else if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos + 1].type == TokenType::LBRACKET)
-		{
-			string var = expect(TokenType::IDENTIFIER).value;
-			expect(TokenType::LBRACKET);
-			auto index = parse_expression();
-			expect(TokenType::RBRACKET);
-
-			if (variables.find(var) == variables.end())
-				throw runtime_error("Undefined Variable " + var + " at Line " + to_string(tokens[pos].line));
-
-			CollectionType var_type = variables[var];
-
-			if (var_type.base_type == VarType::LIST || var_type.base_type == VarType::TUPLE)
-			{
-				result = var + "->data[" + index.first + "]";
-				type = var_type.element_type;
-				expr_type = { var_type.element_type, VarType::NONE, VarType::NONE, VarType::NONE };
-
-				if (var_type.base_type == VarType::LIST)
-					helper_includes.insert("list_" + vartype_to_c(var_type.element_type) + ".h");
-				else
-					helper_includes.insert("tuple_" + vartype_to_c(var_type.element_type) + ".h");
-			}
-			else if (var_type.base_type == VarType::DICT)
-			{
-				string temp_var = "temp_dict_get_" + to_string(rand());
-				result = "dict_get_" + vartype_to_c(var_type.key_type) + vartype_to_c(var_type.value_type) + "(" + var + ", " + index.first + ")";
-				type = var_type.value_type;
-				expr_type = { var_type.value_type, VarType::NONE, VarType::NONE, VarType::NONE };
-				helper_includes.insert("dict_string_" + vartype_to_c(var_type.value_type) + ".h");
-			}
-			else
-				throw runtime_error("Indexing Only Supported for Lists, Tuples, and Dicts at Line " + to_string(tokens[pos].line));
-		}
-		else if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos + 1].type == TokenType::DOT)
-		{
-			string var = expect(TokenType::IDENTIFIER).value;
-			expect(TokenType::DOT);
-			string method = expect(TokenType::CALL_METHOD).value;
-			expect(TokenType::LPAREN);
-			vector<string> args;
-
-			if (tokens[pos].type != TokenType::RPAREN)
-			{
-				auto expr = parse_expression();
-				args.push_back(expr.first);
-
-				while (tokens[pos].type == TokenType::COMMA)
-				{
-					expect(TokenType::COMMA);
-					expr = parse_expression();
-					args.push_back(expr.first);
-				}
-			}
-
-			expect(TokenType::RPAREN);
-
-			if (variables.find(var) == variables.end())
-				throw runtime_error("Undefined Variable " + var + " at Line " + to_string(tokens[pos].line));
-
-			CollectionType var_type = variables[var];
-
-			if (var_type.base_type != VarType::STRING && var_type.base_type != VarType::LIST)
-				throw runtime_error("Method Call Only Supported for Strings and Lists at Line " + to_string(tokens[pos].line));
-
-			CollectionType return_type;
-
-			if (method == "append")
-			{
-				if (var_type.base_type != VarType::LIST)
-					throw runtime_error("Append Method Only Supported for Lists at Line " + to_string(tokens[pos].line));
-
-				helper_includes.insert("list_" + vartype_to_c(var_type.element_type) + ".h");
-				return_type = { VarType::NONE, VarType::NONE, VarType::NONE, VarType::NONE };
-			}
-			else if (method == "upper" || method == "lower" || method == "strip" ||
-				method == "replace" || method == "split" || method == "find")
-			{
-				if (var_type.base_type != VarType::STRING)
-					throw runtime_error("String Method Only Supported for Strings at Line " + to_string(tokens[pos].line));
-
-				helper_includes.insert("string_utils.h");
-
-				if (method == "split")
-					return_type = { VarType::LIST, VarType::STRING, VarType::NONE, VarType::NONE };
-				else if (method == "find")
-					return_type = { VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE };
-				else
-					return_type = { VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE };
-			}
-			else
-				throw runtime_error("Unsupported Method " + method + " at Line " + to_string(tokens[pos].line));
-
-			string temp_var = "temp_method_" + to_string(rand());
-
-			if (method == "append")
-			{
-				result = "list_append_" + vartype_to_c(var_type.element_type) + "(" + var + ", " + args[0] + ")";
-				type = VarType::NONE;
-			}
-			else if (method == "upper" || method == "lower" || method == "strip")
-			{
-				result = "char* " + temp_var + " = str_" + method + "(" + var + ")";
-				type = VarType::STRING;
-			}
-			else if (method == "replace")
-			{
-				result = "char* " + temp_var + " = str_replace(" + var + ", " + args[0] + ", " + args[1] + ")";
-				type = VarType::STRING;
-			}
-			else if (method == "split")
-			{
-				result = "ListString* " + temp_var + " = str_split(" + var +
-					(args.empty() ? ", NULL" : ", " + args[0]) + ")";
-				type = VarType::LIST;
-				expr_type = { VarType::LIST, VarType::STRING, VarType::NONE, VarType::NONE };
-			}
-			else if (method == "find")
-			{
-				result = "int " + temp_var + " = str_find(" + var + ", " + args[0] + ")";
-				type = VarType::INT;
-			}
-		}
-		else if (tokens[pos].type == TokenType::IDENTIFIER)
-		{
-			string var = expect(TokenType::IDENTIFIER).value;
-
-			if (variables.find(var) == variables.end())
-				throw runtime_error("Undefined Variable " + var + " at Line " + to_string(tokens[pos].line));
-
-			result = var;
-			type = variables[var].base_type;
-			expr_type = variables[var];
-
-			if (type == VarType::LIST)
-				helper_includes.insert("list_" + vartype_to_c(expr_type.element_type) + ".h");
-			else if (type == VarType::TUPLE)
-				helper_includes.insert("tuple_" + vartype_to_c(expr_type.element_type) + ".h");
-			else if (type == VarType::DICT)
-				helper_includes.insert("dict_string_" + vartype_to_c(expr_type.value_type) + ".h");
-			else if (type == VarType::STRING)
-				helper_includes.insert("string_utils.h");
-		}
-		else if (tokens[pos].type == TokenType::FSTRING_START)
-		{
-			expect(TokenType::FSTRING_START);
-
-			string format;
-			vector<string> args;
-			vector<VarType> arg_types;
-
-			while (tokens[pos].type != TokenType::FSTRING_END)
-			{
-				if (tokens[pos].type == TokenType::STRING_LITERAL)
-				{
-					string str = expect(TokenType::STRING_LITERAL).value;
-					format += str;
-					helper_includes.insert("string_utils.h");
-				}
-				else if (tokens[pos].type == TokenType::FSTRING_EXPR_START)
-				{
-					expect(TokenType::FSTRING_EXPR_START);
-
-					auto expr = parse_expression();
-					args.push_back(expr.first);
-					arg_types.push_back(expr.second);
-					FormatSpec spec;
-
-					if (tokens[pos].type == TokenType::FSTRING_FORMAT_SPEC)
-					{
-						string format_spec = expect(TokenType::FSTRING_FORMAT_SPEC).value;
-						size_t i = 0;
-
-						if (format_spec[i] == '<' || format_spec[i] == '>' || format_spec[i] == '^')
-						{
-							spec.alignment = format_spec[i];
-							i++;
-						}
-
-						while (i < format_spec.size() && isdigit(format_spec[i]))
-						{
-							spec.width += format_spec[i];
-							i++;
-						}
-
-						if (i < format_spec.size() && format_spec[i] == '.')
-						{
-							i++;
-
-							while (i < format_spec.size() && isdigit(format_spec[i]))
-							{
-								spec.precision += format_spec[i];
-								i++;
-							}
-						}
-
-						if (i < format_spec.size())
-							spec.type = format_spec[i];
-
-						string format_str;
-
-						if (!spec.alignment.empty())
-							format_str += spec.alignment;
-
-						if (!spec.width.empty())
-							format_str += spec.width;
-
-						if (!spec.precision.empty())
-							format_str += "." + spec.precision;
-
-						format_str += spec.type;
-						format += "%" + format_str;
-					}
-					else
-					{
-						if (expr.second == VarType::INT)
-							format += "%d";
-						else if (expr.second == VarType::FLOAT)
-							format += "%f";
-						else if (expr.second == VarType::STRING)
-							format += "%s";
-						else if (expr.second == VarType::BOOL)
-							format += "%s";
-						else if (expr.second == VarType::LIST || expr.second == VarType::TUPLE || expr.second == VarType::DICT)
-						{
-							format += "%s";
-
-							if (expr.second == VarType::LIST)
-								helper_includes.insert("list_" + vartype_to_c(expr_type.element_type) + ".h");
-							else if (expr.second == VarType::TUPLE)
-								helper_includes.insert("tuple_" + vartype_to_c(expr_type.element_type) + ".h");
-							else if (expr.second == VarType::DICT)
-								helper_includes.insert("dict_string_" + vartype_to_c(expr_type.value_type) + ".h");
-						}
-					}
-
-					expect(TokenType::FSTRING_EXPR_END);
-				}
-			}
-
-			expect(TokenType::FSTRING_END);
-
-			string temp_var = "temp_string_" + to_string(string_temp_counter++);
-			result = "char " + temp_var + "[1024];\n";
-			result += "snprintf(" + temp_var + ", 1024, \"" + format + "\"";
-
-			for (const auto& arg : args)
-			{
-				result += ", ";
-
-				if (arg_types[&arg - &args[0]] == VarType::BOOL)
-					result += arg + " ? \"true\" : \"false\"";
-				else if (arg_types[&arg - &args[0]] == VarType::LIST)
-				{
-					result += "list_to_string_" + vartype_to_c(expr_type.element_type) + "(" + arg + ")";
-					helper_includes.insert("list_" + vartype_to_c(expr_type.element_type) + ".h");
-				}
-				else if (arg_types[&arg - &args[0]] == VarType::TUPLE)
-				{
-					result += "tuple_to_string_" + vartype_to_c(expr_type.element_type) + "(" + arg + ")";
-					helper_includes.insert("tuple_" + vartype_to_c(expr_type.element_type) + ".h");
-				}
-				else if (arg_types[&arg - &args[0]] == VarType::DICT)
-				{
-					result += "dict_to_string_" + vartype_to_c(expr_type.key_type) + vartype_to_c(expr_type.value_type) + "(" + arg + ")";
-					helper_includes.insert("dict_string_" + vartype_to_c(expr_type.value_type) + ".h");
-				}
-				else
-					result += arg;
-			}
-
-			result += ");\n    " + temp_var;
-			type = VarType::STRING;
-			expr_type = { VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE };
-			helper_includes.insert("string_utils.h");
-		}
-		else if (tokens[pos].type == TokenType::LBRACKET)
-		{
-			expect(TokenType::LBRACKET);
-			vector<string> elements;
-			CollectionType list_type;
-
-			if (tokens[pos].type != TokenType::RBRACKET)
-			{
-				auto expr = parse_expression();
-				elements.push_back(expr.first);
-				list_type.element_type = expr.second;
-
-				while (tokens[pos].type == TokenType::COMMA)
-				{
-					expect(TokenType::COMMA);
-					expr = parse_expression();
-
-					if (expr.second != list_type.element_type)
-						throw runtime_error("Inconsistent List Element Types at Line " + to_string(tokens[pos].line));
-
-					elements.push_back(expr.first);
-				}
-			}
-
-			expect(TokenType::RBRACKET);
-			list_type.base_type = VarType::LIST;
-			helper_includes.insert("list_" + vartype_to_c(list_type.element_type) + ".h");
-
-			//return make_unique<ListNode>(elements, list_type);
-
-			string temp_var = "temp_list_" + to_string(string_temp_counter++);
-			string result = vartype_to_c(list_type.element_type) + "List*" + temp_var + " = create_list_" + vartype_to_c(list_type.element_type) + "();\n";
-
-			for (const auto& elem : elements)
-				result += "list_append_" + vartype_to_c(list_type.element_type) + "(" + temp_var + ", " + elem + ");\n";
-
-			result += temp_var;
-			type = VarType::LIST;
-			expr_type = list_type;
-
-			return{ result, type };
-		}
-		else if (tokens[pos].type == TokenType::LPAREN)
-		{
-			expect(TokenType::LPAREN);
-			vector<string> elements;
-			CollectionType tuple_type;
-
-			if (tokens[pos].type != TokenType::RPAREN)
-			{
-				auto expr = parse_expression();
-				elements.push_back(expr.first);
-				tuple_type.element_type = expr.second;
-
-				while (tokens[pos].type == TokenType::COMMA)
-				{
-					expect(TokenType::COMMA);
-					expr = parse_expression();
-
-					if (expr.second != tuple_type.element_type)
-						throw runtime_error("Inconsistent tuple element types at line " + to_string(tokens[pos].line));
-
-					elements.push_back(expr.first);
-				}
-			}
-
-			expect(TokenType::RPAREN);
-			tuple_type.base_type = VarType::TUPLE;
-			helper_includes.insert("tuple_" + vartype_to_c(tuple_type.element_type) + ".h");
-
-			//return make_unique<TupleNode>(elements, tuple_type);
-
-			string temp_var = "temp_tuple_" + to_string(string_temp_counter++);
-			string result = vartype_to_c(tuple_type.element_type) + "Tuple* " + temp_var + " = create_tuple_" + vartype_to_c(tuple_type.element_type) + "(" + to_string(elements.size()) + ");\n";
-
-			for (size_t i = 0; i < elements.size(); ++i)
-				result += temp_var + "->data[" + to_string(i) + "] = " + elements[i] + ";\n";
-
-			result += temp_var;
-			type = VarType::TUPLE;
-			expr_type = tuple_type;
-
-			return{ result, type };
-		}
-		else if (tokens[pos].type == TokenType::LBRACE)
-		{
-			expect(TokenType::LBRACE);
-			vector<pair<string, string>> entries;
-			CollectionType dict_type;
-
-			if (tokens[pos].type != TokenType::RBRACE)
-			{
-				auto key = parse_expression();
-
-				if (key.second != VarType::STRING)
-					throw runtime_error("Dictionary Key Must be a String at Line " + to_string(tokens[pos].line));
-
-				expect(TokenType::COLON);
-				auto value = parse_expression();
-				entries.emplace_back(key.first, value.first);
-				dict_type.key_type = VarType::STRING;
-				dict_type.value_type = value.second;
-
-				while (tokens[pos].type == TokenType::COMMA)
-				{
-					expect(TokenType::COMMA);
-					key = parse_expression();
-
-					if (key.second != VarType::STRING)
-						throw runtime_error("Dictionary Key Must be a String at Line " + to_string(tokens[pos].line));
-
-					expect(TokenType::COLON);
-					value = parse_expression();
-
-					if (value.second != dict_type.value_type)
-						throw runtime_error("Inconsistent Dictionary Value Types at Line " + to_string(tokens[pos].line));
-
-					entries.emplace_back(key.first, value.first);
-				}
-			}
-
-			expect(TokenType::RBRACE);
-			dict_type.base_type = VarType::DICT;
-			helper_includes.insert("dict_string_" + vartype_to_c(dict_type.value_type) + ".h");
-
-			//return make_unique<DictNode>(entries, dict_type);
-
-			string temp_var = "temp_dict_" + to_string(string_temp_counter++);
-			string result = "DictString" + vartype_to_c(dict_type.value_type) + "* " + temp_var + " = create_dict_string_" + vartype_to_c(dict_type.value_type) + "();\n";
-
-			for (const auto& entry : entries)
-				result += "dict_set_string_" + vartype_to_c(dict_type.value_type) + "(" + temp_var + ", " + entry.first + ", " + entry.second + ");\n";
-
-			result += temp_var;
-			type = VarType::DICT;
-			expr_type = dict_type;
-
-			return{ result, type };
-		}
-		else if (tokens[pos].type == TokenType::LEN)
-		{
-			expect(TokenType::LEN);
-			expect(TokenType::LPAREN);
-			auto expr = parse_expression();
-			expect(TokenType::RPAREN);
-
-			if (expr.second != VarType::STRING && expr.second != VarType::LIST &&
-				expr.second != VarType::TUPLE && expr.second != VarType::DICT)
-				throw runtime_error("LEN Function Only Supported for Strings, Lists, Tuples, and Dicts at Line " + to_string(tokens[pos].line));
-
-			if (expr.second == VarType::STRING)
-			{
-				helper_includes.insert("string_utils.h");
-				result = "strlen(" + expr.first + ")";
-			}
-			else if (expr.second == VarType::LIST)
-			{
-				helper_includes.insert("list_" + vartype_to_c(expr_type.element_type) + ".h");
-				result = expr.first + "->size";
-			}
-			else if (expr.second == VarType::TUPLE)
-			{
-				helper_includes.insert("tuple_" + vartype_to_c(expr_type.element_type) + ".h");
-				result = expr.first + "->size";
-			}
-			else if (expr.second == VarType::DICT)
-			{
-				helper_includes.insert("dict_string_" + vartype_to_c(expr_type.value_type) + ".h");
-				result = expr.first + "->size";
-			}
-
-			type = VarType::INT;
-			expr_type = { VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE };
-
-			return{ result, type };
-
-			//return make_unique<LenNode>(expr.first, expr_type);
-		}
-		else
-			throw runtime_error("Invalid Expression at Line " + to_string(tokens[pos].line));
-
-		while (tokens[pos].type == TokenType::PLUS || tokens[pos].type == TokenType::MINUS ||
-			tokens[pos].type == TokenType::MULT || tokens[pos].type == TokenType::DIV ||
-			tokens[pos].type == TokenType::EQ || tokens[pos].type == TokenType::NOTEQ ||
-			tokens[pos].type == TokenType::LESSER || tokens[pos].type == TokenType::GREATER ||
-			tokens[pos].type == TokenType::LESSEREQ || tokens[pos].type == TokenType::GREATEREQ ||
-			tokens[pos].type == TokenType::AND || tokens[pos].type == TokenType::OR)
-		{
-			string op;
-			VarType result_type = type;
-
-			if (tokens[pos].type == TokenType::PLUS)
-			{
-				op = "+";
-				expect(TokenType::PLUS);
-
-				if (type == VarType::STRING || type == VarType::LIST)
-				{
-					result_type = type;
-
-					if (type == VarType::STRING)
-						helper_includes.insert("string_utils.h");
-					else
-						helper_includes.insert("list_" + vartype_to_c(expr_type.element_type) + ".h");
-				}
-				else if (type == VarType::INT || type == VarType::FLOAT)
-					result_type = type;
-				else
-					throw runtime_error("Invalid Operand Types for '+' at Line " + to_string(tokens[pos].line));
-			}
-			else if (tokens[pos].type == TokenType::MINUS)
-			{
-				op = "-";
-				expect(TokenType::MINUS);
-
-				if (type != VarType::INT && type != VarType::FLOAT)
-					throw std::runtime_error("Invalid Operand Types for '-' at Line " + to_string(tokens[pos].line));
-
-				result_type = type;
-			}
-			else if (tokens[pos].type == TokenType::MULT)
-			{
-				op = "*";
-				expect(TokenType::MULT);
-
-				if (type != VarType::INT && type != VarType::FLOAT)
-					throw runtime_error("Invalid Operand Types for '*' at Line " + to_string(tokens[pos].line));
-
-				result_type = type;
-			}
-			else if (tokens[pos].type == TokenType::DIV)
-			{
-				op = "/";
-				expect(TokenType::DIV);
-
-				if (type != VarType::INT && type != VarType::FLOAT)
-					throw runtime_error("Invalid Operand Types for '/' at Line " + to_string(tokens[pos].line));
-
-				result_type = VarType::FLOAT;
-			}
-			else if (tokens[pos].type == TokenType::EQ)
-			{
-				op = "==";
-				expect(TokenType::EQ);
-
-				result_type = VarType::BOOL;
-			}
-			else if (tokens[pos].type == TokenType::NOTEQ)
-			{
-				op = "!=";
-				expect(TokenType::NOTEQ);
-
-				result_type = VarType::BOOL;
-			}
-			else if (tokens[pos].type == TokenType::GREATER)
-			{
-				op = ">";
-				expect(TokenType::GREATER);
-
-				result_type = VarType::BOOL;
-			}
-			else if (tokens[pos].type == TokenType::LESSER)
-			{
-				op = "<";
-				expect(TokenType::LESSER);
-
-				result_type = VarType::BOOL;
-			}
-			else if (tokens[pos].type == TokenType::GREATEREQ)
-			{
-				op = ">=";
-				expect(TokenType::GREATEREQ);
-
-				result_type = VarType::BOOL;
-			}
-			else if (tokens[pos].type == TokenType::LESSEREQ)
-			{
-				op = ">=";
-				expect(TokenType::LESSEREQ);
-
-				result_type = VarType::BOOL;
-			}
-			else if (tokens[pos].type == TokenType::AND)
-			{
-				op = "&&";
-				expect(TokenType::AND);
-
-				if (type != VarType::BOOL)
-					throw runtime_error("Invalid Operand Types for 'AND' at Line " + to_string(tokens[pos].line));
-
-				result_type = VarType::BOOL;
-			}
-			else if (tokens[pos].type == TokenType::OR)
-			{
-				op = "||";
-				expect(TokenType::OR);
-
-				if (type != VarType::BOOL)
-					throw runtime_error("Invalid Operand Types for 'OR' at Line " + to_string(tokens[pos].line));
-
-				result_type = VarType::BOOL;
-			}
-
-			auto right = parse_expression();
-
-			if (type != VarType::BOOL && right.second != VarType::BOOL &&
-				type != right.second && !(type == VarType::FLOAT && right.second == VarType::INT))
-				throw runtime_error("Type Mismatch in Operation at Line " + to_string(tokens[pos].line));
-
-			/*
-			if (result.first.find("snprintf") != string::npos)
-			{
-				string temp_var = result.substr(result.first.find_last_of(' ') + 1);
-
-				result = temp_var;
-			}
-			*/
-
-			if (right.first.find("snprintf") != string::npos)
-			{
-				string temp_var = right.first.substr(right.first.find_last_of(' ') + 1);
-				right.first = temp_var;
-			}
-
-			result = "(" + result + " " + op + " " + right.first + ")";
-			type = result_type;
-			expr_type.base_type = result_type;
-		}
-
-		return{ result, type };
-	}
-
-	unique_ptr<ASTNode> parse_assignment()
-	{
-		CollectionType type = parse_collection_type();
-		string var = expect(TokenType::IDENTIFIER).value;
-		expect(TokenType::EQUALS);
-		auto expr = parse_expression();
-
-		if (type.base_type == VarType::INT && expr.second != VarType::INT)
-			throw runtime_error("Type Mismatch in Assignment at Line " + to_string(tokens[pos].line));
-
-		if (type.base_type == VarType::FLOAT && expr.second != VarType::FLOAT && expr.second != VarType::INT)
-			throw runtime_error("Type Mismatch in Assignment at Line " + to_string(tokens[pos].line));
-
-		if (type.base_type == VarType::STRING && expr.second != VarType::STRING)
-			throw runtime_error("Type Mismatch in Assignment at Line " + to_string(tokens[pos].line));
-
-		if (type.base_type == VarType::BOOL && expr.second != VarType::BOOL)
-			throw runtime_error("Type Mismatch in Assignment at Line " + to_string(tokens[pos].line));
-
-		if (type.base_type == VarType::LIST && (expr.second != VarType::LIST || type.element_type != expr_type.element_type))
-			throw runtime_error("Type Mismatch in List Assignment at Line " + to_string(tokens[pos].line));
-
-		if (type.base_type == VarType::TUPLE && (expr.second != VarType::TUPLE || type.element_type != expr_type.element_type))
-			throw runtime_error("Type Mismatch in Tuple Assignment at Line " + to_string(tokens[pos].line));
-
-		if (type.base_type == VarType::DICT && (expr.second != VarType::DICT ||
-			type.key_type != expr_type.key_type || type.value_type != expr_type.value_type))
-			throw runtime_error("Type Mismatch in Dict Assignment at Line " + to_string(tokens[pos].line));
-
-		bool is_declaration = variables.find(var) == variables.end();
-		variables[var] = type;
-
-		expect(TokenType::NEWLINE);
-
-		return make_unique<AssignNode>(var, expr.first, type, is_declaration);
-	}
-
-	unique_ptr<ASTNode> parse_function()
-	{
-		expect(TokenType::DEF);
-
-		string name = expect(TokenType::IDENTIFIER).value;
-
-		expect(TokenType::LPAREN);
-
-		vector<pair<string, CollectionType>> args;
-		vector<CollectionType> arg_types;
-
-		if (tokens[pos].type != TokenType::RPAREN)
-		{
-			CollectionType type = parse_collection_type();
-			string arg_name = expect(TokenType::IDENTIFIER).value;
-
-			args.emplace_back(arg_name, type);
-			arg_types.push_back(type);
-			variables[arg_name] = type;
-
-			while (tokens[pos].type == TokenType::COMMA)
-			{
-				expect(TokenType::COMMA);
-
-				type = parse_collection_type();
-				arg_name = expect(TokenType::IDENTIFIER).value;
-
-				args.emplace_back(arg_name, type);
-				arg_types.push_back(type);
-				variables[arg_name] = type;
-			}
-		}
-
-		expect(TokenType::RPAREN);
-
-		CollectionType return_type = { VarType::NONE, VarType::NONE, VarType::NONE, VarType::NONE };
-
-		if (tokens[pos].type == TokenType::COLON && tokens[pos + 1].type != TokenType::NEWLINE)
-		{
-			expect(TokenType::COLON);
-
-			return_type = parse_collection_type();
-		}
-
-		expect(TokenType::COLON);
-		expect(TokenType::NEWLINE);
-		expect(TokenType::INDENT);
-
-		functions[name] = { arg_types, return_type };
-
-		auto func = make_unique<FunctionNode>(name, args, return_type);
-
-		while (tokens[pos].type != TokenType::DEDENT && tokens[pos].type != TokenType::EOF_TOKEN)
-			func->body.push_back(parse_statement());
-
-		expect(TokenType::DEDENT);
-
-		return func;
-	}
-
-	unique_ptr<ASTNode> parse_function_call()
-	{
-		string func_name = expect(TokenType::IDENTIFIER).value;
-
-		expect(TokenType::LPAREN);
-
-		vector<string> args;
-
-		if (tokens[pos].type != TokenType::RPAREN)
-		{
-			auto expr = parse_expression();
-			args.push_back(expr.first);
-
-			while (tokens[pos].type == TokenType::COMMA)
-			{
-				expect(TokenType::COMMA);
-
-				expr = parse_expression();
-				args.push_back(expr.first);
-			}
-		}
-
-		expect(TokenType::RPAREN);
-		expect(TokenType::NEWLINE);
-
-		if (functions.find(func_name) == functions.end())
-			throw runtime_error("Undefined Function " + func_name + " at Line " + to_string(tokens[pos].line));
-
-		return make_unique<CallNode>(func_name, args, functions[func_name].second);
-	}
-
-	unique_ptr<ASTNode> parse_method_call()
-	{
-		string var = expect(TokenType::IDENTIFIER).value;
-		expect(TokenType::DOT);
-		string method = expect(TokenType::CALL_METHOD).value;
-		expect(TokenType::LPAREN);
-		vector<string> args;
-
-		if (tokens[pos].type != TokenType::RPAREN)
-		{
-			auto expr = parse_expression();
-			args.push_back(expr.first);
-
-			while (tokens[pos].type == TokenType::COMMA)
-			{
-				expect(TokenType::COMMA);
-				expr = parse_expression();
-				args.push_back(expr.first);
-			}
-		}
-
-		expect(TokenType::RPAREN);
-		expect(TokenType::NEWLINE);
-
-		if (variables.find(var) == variables.end())
-			throw runtime_error("Undefined Variable " + var + " at Line " + to_string(tokens[pos].line));
-
-		CollectionType var_type = variables[var];
-
-		if (var_type.base_type != VarType::STRING && var_type.base_type != VarType::LIST)
-			throw runtime_error("Method Call Only Supported for Strings and Lists at Line " + to_string(tokens[pos].line));
-
-		CollectionType return_type;
-
-		if (method == "append")
-		{
-			if (var_type.base_type != VarType::LIST)
-				throw runtime_error("'Append' Method Only Supported for Lists at Line " + to_string(tokens[pos].line));
-
-			helper_includes.insert("list_" + vartype_to_c(var_type.element_type) + ".h");
-			return_type = { VarType::NONE, VarType::NONE, VarType::NONE, VarType::NONE };
-		}
-		else if (method == "upper" || method == "lower" || method == "strip" || method == "replace" ||
-			method == "split" || method == "find")
-		{
-			if (var_type.base_type != VarType::STRING)
-				throw runtime_error("'String' Methods Only Supported for Strings at Line " + to_string(tokens[pos].line));
-
-			helper_includes.insert("string_utils.h");
-
-			if (method == "split")
-				return_type = { VarType::LIST, VarType::STRING, VarType::NONE, VarType::NONE };
-			else if (method == "find")
-				return_type = { VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE };
-			else
-				return_type = { VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE };
-		}
-		else
-			throw runtime_error("Unsupported Method " + method + " at Line " + to_string(tokens[pos].line));
-
-		return make_unique<MethodCallNode>(var, method, args, return_type);
-	}
-
-	unique_ptr<ASTNode> parse_return()
-	{
-		expect(TokenType::RETURN);
-		auto expr = parse_expression();
-		expect(TokenType::NEWLINE);
-
-		return make_unique<ReturnNode>(expr.first, expr_type);
-	}
-
-	unique_ptr<ASTNode> parse_print()
-	{
-		expect(TokenType::PRINT);
-		expect(TokenType::LPAREN);
-
-		vector<pair<string, VarType>> values;
-		string separator = " ";
-
-		if (tokens[pos].type != TokenType::RPAREN)
-		{
-			auto expr = parse_expression();
-
-			if ((expr.second == VarType::STRING || expr.second == VarType::LIST ||
-				expr.second == VarType::TUPLE || expr.second == VarType::DICT) &&
-				expr.first.find("snprintf") != string::npos)
-			{
-				string temp_var = expr.first.substr(expr.first.find_last_of(' ') + 1);
-				values.emplace_back(temp_var, expr.second);
-			}
-			else
-				values.emplace_back(expr.first, expr.second);
-
-			// Register includes for collection types in print
-			if (expr.second == VarType::LIST)
-				helper_includes.insert("list_" + vartype_to_c(expr_type.element_type) + ".h");
-			else if (expr.second == VarType::TUPLE)
-				helper_includes.insert("tuple_" + vartype_to_c(expr_type.element_type) + ".h");
-			else if (expr.second == VarType::DICT)
-				helper_includes.insert("dict_string_" + vartype_to_c(expr_type.value_type) + ".h");
-			else if (expr.second == VarType::STRING)
-				helper_includes.insert("string_utils.h");
-
-			while (tokens[pos].type == TokenType::COMMA)
-			{
-				expect(TokenType::COMMA);
-
-				if (tokens[pos].type == TokenType::SEP)
-				{
-					expect(TokenType::SEP);
-					expect(TokenType::EQUALS);
-
-					if (tokens[pos].type != TokenType::STRING_LITERAL)
-						throw runtime_error("Separator Must be a String at Line " + to_string(tokens[pos].line));
-
-					separator = expect(TokenType::STRING_LITERAL).value;
-					helper_includes.insert("string_utils.h");
-
-					break;
-				}
-
-				expr = parse_expression();
-
-				if ((expr.second == VarType::STRING || expr.second == VarType::LIST ||
-					expr.second == VarType::TUPLE || expr.second == VarType::DICT) &&
-					expr.first.find("snprintf") != string::npos)
-				{
-					string temp_var = expr.first.substr(expr.first.find_last_of(' ') + 1);
-					values.emplace_back(temp_var, expr.second);
-				}
-				else
-					values.emplace_back(expr.first, expr.second);
-
-				if (expr.second == VarType::LIST)
-					helper_includes.insert("list_" + vartype_to_c(expr_type.element_type) + ".h");
-				else if (expr.second == VarType::TUPLE)
-					helper_includes.insert("tuple_" + vartype_to_c(expr_type.element_type) + ".h");
-				else if (expr.second == VarType::DICT)
-					helper_includes.insert("dict_string_" + vartype_to_c(expr_type.value_type) + ".h");
-				else if (expr.second == VarType::STRING)
-					helper_includes.insert("string_utils.h");
-			}
-		}
-
-		expect(TokenType::RPAREN);
-		expect(TokenType::NEWLINE);
-
-		return make_unique<PrintNode>(values, separator);
-	}
-
-	unique_ptr<ASTNode> parse_if()
-	{
-		expect(TokenType::IF);
-
-		auto condition = parse_expression();
-
-		expect(TokenType::COLON);
-		expect(TokenType::NEWLINE);
-		expect(TokenType::INDENT);
-
-		auto if_node = make_unique<IfNode>(condition.first);
-
-		while (tokens[pos].type != TokenType::DEDENT && tokens[pos].type != TokenType::ELIF &&
-			tokens[pos].type != TokenType::ELSE && tokens[pos].type != TokenType::EOF_TOKEN)
-			if_node->body.push_back(parse_statement());
-
-		expect(TokenType::DEDENT);
-
-		while (tokens[pos].type == TokenType::ELIF)
-		{
-			expect(TokenType::ELIF);
-
-			auto elif_condition = parse_expression();
-
-			expect(TokenType::COLON);
-			expect(TokenType::NEWLINE);
-			expect(TokenType::INDENT);
-
-			vector<unique_ptr<ASTNode>> elif_body;
-
-			while (tokens[pos].type != TokenType::DEDENT && tokens[pos].type != TokenType::ELIF &&
-				tokens[pos].type != TokenType::ELSE && tokens[pos].type != TokenType::EOF_TOKEN)
-				elif_body.push_back(parse_statement());
-
-			expect(TokenType::DEDENT);
-
-			if_node->elif_clauses.emplace_back(elif_condition.first, move(elif_body));
-		}
-
-		if (tokens[pos].type == TokenType::ELSE)
-		{
-			expect(TokenType::ELSE);
-			expect(TokenType::COLON);
-			expect(TokenType::NEWLINE);
-			expect(TokenType::INDENT);
-
-			while (tokens[pos].type != TokenType::DEDENT && tokens[pos].type != TokenType::EOF_TOKEN)
-				if_node->else_body.push_back(parse_statement());
-
-			expect(TokenType::DEDENT);
-		}
-
-		return if_node;
-	}
-
-	unique_ptr<ASTNode> parse_for()
-	{
-		expect(TokenType::FOR);
-		string var = expect(TokenType::IDENTIFIER).value;
-		expect(TokenType::IN);
-		expect(TokenType::RANGE);
-		expect(TokenType::LPAREN);
-
-		auto start = parse_expression();
-
-		expect(TokenType::COMMA);
-
-		auto end = parse_expression();
-
-		expect(TokenType::RPAREN);
-		expect(TokenType::COLON);
-		expect(TokenType::NEWLINE);
-		expect(TokenType::INDENT);
-
-		auto for_node = make_unique<ForNode>(var, start.first, end.first);
-		variables[var] = { VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE };
-
-		while (tokens[pos].type != TokenType::DEDENT && tokens[pos].type != TokenType::EOF_TOKEN)
-			for_node->body.push_back(parse_statement());
-
-		expect(TokenType::DEDENT);
-
-		return for_node;
-	}
-
-	unique_ptr<ASTNode> parse_while()
-	{
-		expect(TokenType::WHILE);
-
-		auto condition = parse_expression();
-
-		expect(TokenType::COLON);
-		expect(TokenType::NEWLINE);
-		expect(TokenType::INDENT);
-
-		auto while_node = make_unique<WhileNode>(condition.first);
-
-		while (tokens[pos].type != TokenType::DEDENT && tokens[pos].type != TokenType::EOF_TOKEN)
-			while_node->body.push_back(parse_statement());
-
-		expect(TokenType::DEDENT);
-
-		return while_node;
-	}
-
-	unique_ptr<ASTNode> parse_match()
-	{
-		expect(TokenType::MATCH);
-		auto expr = parse_expression();
-
-		if (expr.second != VarType::INT && expr.second != VarType::BOOL)
-			throw runtime_error("Match expression must be int or bool at line " + to_string(tokens[pos].line));
-
-		expect(TokenType::COLON);
-		expect(TokenType::NEWLINE);
-		expect(TokenType::INDENT);
-
-		auto match_node = make_unique<MatchNode>(expr.first, expr.second);
-
-		while (tokens[pos].type == TokenType::CASE)
-		{
-			expect(TokenType::CASE);
-			string pattern = "_";
-
-			if (tokens[pos].type == TokenType::NUMBER)
-				pattern = expect(TokenType::NUMBER).value;
-			else if (tokens[pos].type == TokenType::TRUE || tokens[pos].type == TokenType::FALSE)
-				pattern = expect(tokens[pos].type).value;
-			else if (tokens[pos].type == TokenType::IDENTIFIER && tokens[pos].value == "_")
-				expect(TokenType::IDENTIFIER);
-
-			expect(TokenType::COLON);
-			expect(TokenType::NEWLINE);
-			expect(TokenType::INDENT);
-
-			vector<unique_ptr<ASTNode>> case_body;
-
-			while (tokens[pos].type != TokenType::DEDENT && tokens[pos].type != TokenType::EOF_TOKEN)
-				case_body.push_back(parse_statement());
-
-			expect(TokenType::DEDENT);
-
-			if (pattern == "_")
-				match_node->default_case = move(case_body);
-			else
-				match_node->cases.emplace_back(pattern, move(case_body));
-		}
-
-		expect(TokenType::DEDENT);
-
-		return match_node;
-	}
-
-	unique_ptr<ASTNode> parse_index_assignment()
-	{
-		string var = expect(TokenType::IDENTIFIER).value;
-		expect(TokenType::LBRACKET);
-
-		auto index = parse_expression();
-
-		expect(TokenType::RBRACKET);
-		expect(TokenType::EQUALS);
-
-		auto value = parse_expression();
-
-		expect(TokenType::NEWLINE);
-
-		if (variables.find(var) == variables.end())
-			throw runtime_error("Undefined Variable " + var + " at Line " + to_string(tokens[pos].line));
-
-		CollectionType var_type = variables[var];
-
-		if (var_type.base_type != VarType::LIST && var_type.base_type != VarType::DICT)
-			throw runtime_error("Indexing Only Supported for Lists and Dicts at Line " + to_string(tokens[pos].line));
-
-		if (var_type.base_type == VarType::LIST && index.second != VarType::INT)
-			throw runtime_error("List Index Must be an Integer at Line " + to_string(tokens[pos].line));
-
-		if (var_type.base_type == VarType::DICT && index.second != VarType::STRING)
-			throw runtime_error("Dict Index Must be a String at Line " + to_string(tokens[pos].line));
-
-		if (var_type.base_type == VarType::LIST && var_type.element_type != value.second)
-			throw runtime_error("Type Mismatch in List Assignment at Line " + to_string(tokens[pos].line));
-
-		if (var_type.base_type == VarType::DICT && var_type.value_type != value.second)
-			throw runtime_error("Type Mismatch in Dict Assignment at Line " + to_string(tokens[pos].line));
-
-		// Register includes for index assignment
-		if (var_type.base_type == VarType::LIST)
-			helper_includes.insert("list_" + vartype_to_c(var_type.element_type) + ".h");
-		else
-			helper_includes.insert("dict_string_" + vartype_to_c(var_type.value_type) + ".h");
-
-		string code;
-
-		if (var_type.base_type == VarType::LIST)
-			code = var + "->data[" + index.first + "] = " + value.first + ";\n";
-		else
-			code = "dict_set_" + vartype_to_c(var_type.key_type) + vartype_to_c(var_type.value_type) + "(" + var + ", " + index.first + ", " + value.first + ");\n";
-
-		return make_unique<HelperNode>(code);
-	}
+#pragma once
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <set>
+#include <sstream>
+#include "ASTNodes.h"
+#include "lexer.h"
+#include "hash.h"
+#include "runtime.h"
+
+using namespace std;
+
+//---PARSER---
+class Parser
+{
+private:
+	Lexer& lexer;
+	Arena& arena;						//AST nodes, child lists and names
+	SymbolTable& symbols;
+	Token window[2];					//Current token and one token of lookahead
+	bool has_lookahead;
+	RuntimeFeatures runtime;			//Runtime support the program needs so far
+
+	struct FunctionSignature
+	{
+		bool defined = false;
+		vector<CollectionType> arg_types;
+		CollectionType return_type;
+	};
+
+	enum class ScopeKind
+	{
+		MODULE, FUNCTION, BLOCK
+	};
+
+	//The innermost visible declaration of a name; a NONE base type marks an undeclared variable
+	struct Binding
+	{
+		CollectionType type;
+		int frame = 0;
+		size_t scope = 0;
+		bool owned = false;					//Released by its scope, not borrowed
+		ConstantSlot* constant = nullptr;	//Value while the variable is never reassigned
+		AssignNode* move = nullptr;			//Pending move out of the variable; any later reference withdraws it
+	};
+
+	struct Scope
+	{
+		ScopeKind kind;
+		int frame;							//Function frame; names from other frames are invisible
+		LocalList* owned;
+		vector<pair<uint32_t, Binding>> shadowed;
+	};
+
+	//Indexed by symbol ID
+	vector<Binding> variables;
+	vector<FunctionSignature> functions;
+	vector<Scope> scopes;
+	int frame_count;
+	FunctionNode* current_function;
+	vector<ReturnNode*> function_returns;	//Returns of the function being parsed
+	Hasher* token_hash;					//Receives every consumed token while a function is parsed
+	RuntimeFeatures* function_runtime;	//Receives runtime needs while a function is parsed
+
+	struct FormatSpec
+	{
+		string alignment;
+		string width;
+		string precision;
+		char type;
+	};
+
+public:
+	Parser(Lexer& l, Arena& a, SymbolTable& syms) : lexer(l), arena(a), symbols(syms), has_lookahead(false), frame_count(0),
+		current_function(nullptr), token_hash(nullptr), function_runtime(nullptr)
+	{
+		window[0] = lexer.next();
+	}
+
+	Block parse_program()
+	{
+		Block program(arena);
+
+		push_scope(ScopeKind::MODULE, program.owned);
+
+		while (current().type != TokenType::EOF_TOKEN)
+			program.statements.push_back(parse_statement());
+
+		pop_scope();
+
+		//Constants are only known once every reassignment has been seen
+		fold_block(program, arena);
+		eliminate_dead_code(program, arena);
+
+		//The runtime is only known once every statement has registered what it uses
+		program.statements.insert(program.statements.begin(), arena.make<HelperNode>(arena.copy_string(generate_runtime(runtime))));
+
+		return program;
+	}
+
+private:
+	CollectionType token_to_vartype(TokenType type)
+	{
+		if (type == TokenType::INT)
+			return{ VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE };
+
+		if (type == TokenType::FLOAT)
+			return{ VarType::FLOAT, VarType::NONE, VarType::NONE, VarType::NONE };
+
+		if (type == TokenType::STRING)
+			return{ VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE };
+
+		if (type == TokenType::BOOL)
+			return{ VarType::BOOL, VarType::NONE, VarType::NONE, VarType::NONE };
+
+		throw runtime_error("Invalid Type at Line " + to_string(current().line));
+	}
+
+	const Token& current() const
+	{
+		return window[0];
+	}
+
+	const Token& peek()
+	{
+		if (!has_lookahead)
+		{
+			window[1] = lexer.next();
+			has_lookahead = true;
+		}
+
+		return window[1];
+	}
+
+	Token expect(TokenType type)
+	{
+		if (window[0].type != type)
+			throw runtime_error("Unexpected Token Type at Line " + to_string(window[0].line));
+
+		Token token = window[0];
+		window[0] = has_lookahead ? window[1] : lexer.next();
+		has_lookahead = false;
+
+		if (token_hash)
+		{
+			token_hash->add((uint64_t)token.type);
+			token_hash->add(token.value);
+		}
+
+		return token;
+	}
+
+	//Copies a token's text into the arena so the AST does not depend on the source buffer;
+	//identifiers reuse their interned spelling
+	string_view save(const Token& token)
+	{
+		if (token.symbol != SymbolTable::NONE)
+			return symbols.name(token.symbol);
+
+		return arena.copy_string(token.value);
+	}
+
+	void push_scope(ScopeKind kind, LocalList& owned)
+	{
+		int frame = kind == ScopeKind::FUNCTION ? ++frame_count : (scopes.empty() ? 0 : scopes.back().frame);
+
+		scopes.push_back({ kind, frame, &owned, {} });
+	}
+
+	void pop_scope()
+	{
+		Scope& scope = scopes.back();
+
+		for (auto it = scope.shadowed.rbegin(); it != scope.shadowed.rend(); ++it)
+			variables[it->first] = it->second;
+
+		scopes.pop_back();
+	}
+
+	//Binding visible from the current scope, or null
+	Binding* find_binding(uint32_t symbol)
+	{
+		if (symbol >= variables.size())
+			return nullptr;
+
+		Binding& binding = variables[symbol];
+
+		if (binding.type.base_type == VarType::NONE || binding.frame != scopes.back().frame)
+			return nullptr;
+
+		//Reading the source again means it is still needed after the assignment
+		if (binding.move)
+		{
+			binding.move->move_source = false;
+			binding.move = nullptr;
+		}
+
+		return &binding;
+	}
+
+	//A local heap value assigned to another variable is moved rather than copied when nothing refers
+	//to it afterwards. The move is assumed here and withdrawn by the next reference to the source,
+	//so a variable has at most one pending move. Only locals of the innermost scope qualify, so the
+	//move can never sit in a loop or branch that the source outlives; closing the scope restores the
+	//shadowed binding and with it drops the move.
+	void propose_move(AssignNode* node, uint32_t target)
+	{
+		auto source = dynamic_cast<VarNode*>(node->expr);
+
+		if (!source || !is_heap_type(node->type.base_type))
+			return;
+
+		uint32_t symbol = symbols.intern(source->name);
+		Binding& binding = variables[symbol];
+
+		if (symbol == target || !binding.owned || binding.scope != scopes.size() - 1)
+			return;
+
+		node->move_source = true;
+		binding.move = node;
+	}
+
+	const CollectionType* find_variable(uint32_t symbol)
+	{
+		Binding* binding = find_binding(symbol);
+
+		return binding ? &binding->type : nullptr;
+	}
+
+	//Declares a name in the innermost scope; owned heap values are released when it closes
+	void declare_variable(uint32_t symbol, const CollectionType& type, bool owned)
+	{
+		if (symbol >= variables.size())
+			variables.resize(symbols.size());
+
+		Scope& scope = scopes.back();
+		Binding binding = { type, scope.frame, scopes.size() - 1, owned && is_heap_type(type.base_type) };
+
+		scope.shadowed.emplace_back(symbol, variables[symbol]);
+		variables[symbol] = binding;
+
+		if (binding.owned)
+			scope.owned->emplace_back(symbols.name(symbol), type);
+	}
+
+	//A parameter is borrowed from the caller. Once the body reassigns it, the function copies it on
+	//entry and releases it like a local, so no value stored in it is lost; returns already parsed
+	//release it as well.
+	void adopt_parameter(uint32_t symbol, Binding& binding)
+	{
+		binding.owned = true;
+		scopes[binding.scope].owned->emplace_back(symbols.name(symbol), binding.type);
+
+		for (auto node : function_returns)
+			node->live.emplace_back(symbols.name(symbol), binding.type);
+	}
+
+	//Heap locals owned by every scope of the current function, in declaration order
+	LocalList live_locals()
+	{
+		LocalList live(arena);
+		size_t first = scopes.size() - 1;
+
+		while (first > 0 && scopes[first].kind == ScopeKind::BLOCK)
+			first--;
+
+		for (size_t i = first; i < scopes.size(); ++i)
+			live.insert(live.end(), scopes[i].owned->begin(), scopes[i].owned->end());
+
+		return live;
+	}
+
+	//Statements up to the closing DEDENT, in the scope the caller opened
+	void parse_body(Block& block)
+	{
+		while (current().type != TokenType::DEDENT && current().type != TokenType::EOF_TOKEN)
+			block.statements.push_back(parse_statement());
+
+		expect(TokenType::DEDENT);
+	}
+
+	void parse_block(Block& block)
+	{
+		push_scope(ScopeKind::BLOCK, block.owned);
+		parse_body(block);
+		pop_scope();
+	}
+
+	const FunctionSignature* find_function(uint32_t symbol) const
+	{
+		if (symbol >= functions.size() || !functions[symbol].defined)
+			return nullptr;
+
+		return &functions[symbol];
+	}
+
+	void declare_function(uint32_t symbol, const vector<CollectionType>& arg_types, const CollectionType& return_type)
+	{
+		if (symbol >= functions.size())
+			functions.resize(symbols.size());
+
+		functions[symbol] = { true, arg_types, return_type };
+	}
+
+	//Records a call made from the current function; its output depends on the callee's signature
+	void note_call(string_view name, const FunctionSignature& function)
+	{
+		if (!current_function)
+			return;
+
+		auto& callees = current_function->callees;
+
+		if (find(callees.begin(), callees.end(), name) == callees.end())
+			callees.push_back(name);
+
+		token_hash->add(name);
+
+		//The unit declares the callee's prototype, so it needs the callee's types
+		for (const auto& type : function.arg_types)
+		{
+			hash_type(type);
+			function_runtime->use(type);
+		}
+
+		hash_type(function.return_type);
+		function_runtime->use(function.return_type);
+	}
+
+	void hash_type(const CollectionType& type)
+	{
+		token_hash->add((uint64_t)type.base_type);
+		token_hash->add((uint64_t)type.element_type);
+		token_hash->add((uint64_t)type.key_type);
+		token_hash->add((uint64_t)type.value_type);
+	}
+
+	CollectionType parse_collection_type()
+	{
+		CollectionType result;
+
+		if (current().type == TokenType::LIST)
+		{
+			expect(TokenType::LIST);
+			expect(TokenType::LBRACKET);
+
+			result.base_type = VarType::LIST;
+			result.element_type = token_to_vartype(current().type).base_type;
+
+			expect(current().type);
+			expect(TokenType::RBRACKET);
+
+			include_type(result);
+		}
+		else if (current().type == TokenType::TUPLE)
+		{
+			expect(TokenType::TUPLE);
+			expect(TokenType::LBRACKET);
+
+			result.base_type = VarType::TUPLE;
+			result.element_type = token_to_vartype(current().type).base_type;
+
+			expect(current().type);
+			expect(TokenType::RBRACKET);
+
+			include_type(result);
+		}
+		else if (current().type == TokenType::DICT)
+		{
+			expect(TokenType::DICT);
+			expect(TokenType::LBRACKET);
+
+			result.base_type = VarType::DICT;
+			result.key_type = token_to_vartype(current().type).base_type;
+
+			if (result.key_type != VarType::STRING)
+				throw runtime_error("Dictionary Keys Must be Strings at Line " + to_string(current().line));
+
+			expect(TokenType::STRING);
+			expect(TokenType::COMMA);
+
+			result.value_type = token_to_vartype(current().type).base_type;
+
+			expect(current().type);
+			expect(TokenType::RBRACKET);
+
+			include_type(result);
+		}
+		else
+		{
+			result = token_to_vartype(current().type);
+			expect(current().type);
+			include_type(result);
+		}
+
+		return result;
+	}
+
+	ASTNode* parse_statement()
+	{
+		if (current().type == TokenType::DEF)
+			return parse_function();
+		else if (current().type == TokenType::RETURN)
+			return parse_return();
+		else if (current().type == TokenType::PRINT)
+			return parse_print();
+		else if (current().type == TokenType::IF)
+			return parse_if();
+		else if (current().type == TokenType::FOR)
+			return parse_for();
+		else if (current().type == TokenType::WHILE)
+			return parse_while();
+		else if (current().type == TokenType::MATCH)
+			return parse_match();
+		else if (current().type == TokenType::INT || current().type == TokenType::FLOAT ||
+			current().type == TokenType::STRING || current().type == TokenType::BOOL ||
+			current().type == TokenType::LIST || current().type == TokenType::TUPLE ||
+			current().type == TokenType::DICT)
+			return parse_assignment();
+		else if (current().type == TokenType::IDENTIFIER && peek().type == TokenType::LPAREN)
+			return parse_function_call();
+		else if (current().type == TokenType::IDENTIFIER && peek().type == TokenType::DOT)
+			return parse_method_call();
+		else if (current().type == TokenType::IDENTIFIER && peek().type == TokenType::LBRACKET)
+			return parse_index_assignment();
+		else
+			throw runtime_error("Unexpected Token at Line " + to_string(current().line));
+	}
+
+	//Registers the runtime support a value of the given type depends on, with the program and with the
+	//function being parsed
+	void include_type(const CollectionType& type)
+	{
+		runtime.use(type);
+
+		if (function_runtime)
+			function_runtime->use(type);
+	}
+
+	void include_printed(const CollectionType& type)
+	{
+		runtime.use_printed(type);
+
+		if (function_runtime)
+			function_runtime->use_printed(type);
+	}
+
+	void include_print(const CollectionType& type)
+	{
+		runtime.use_print(type);
+
+		if (function_runtime)
+			function_runtime->use_print(type);
+	}
+
+	void include_method(string_view method, const CollectionType& var_type)
+	{
+		runtime.use_method(method, var_type);
+
+		if (function_runtime)
+			function_runtime->use_method(method, var_type);
+	}
+
+	void include_string_op(StringMethod op)
+	{
+		runtime.string_methods |= RuntimeFeatures::bit(op);
+
+		if (function_runtime)
+			function_runtime->string_methods |= RuntimeFeatures::bit(op);
+	}
+
+	static int precedence(TokenType type)
+	{
+		switch (type)
+		{
+		case TokenType::OR:
+			return 1;
+		case TokenType::AND:
+			return 2;
+		case TokenType::EQ:
+		case TokenType::NOTEQ:
+		case TokenType::GREATER:
+		case TokenType::LESSER:
+		case TokenType::GREATEREQ:
+		case TokenType::LESSEREQ:
+			return 3;
+		case TokenType::PLUS:
+		case TokenType::MINUS:
+			return 4;
+		case TokenType::MULT:
+		case TokenType::DIV:
+			return 5;
+		default:
+			return 0;			//Not a binary operator
+		}
+	}
+
+	ExprList parse_arguments()
+	{
+		ExprList args(arena);
+
+		if (current().type != TokenType::RPAREN)
+		{
+			args.push_back(parse_expression());
+
+			while (current().type == TokenType::COMMA)
+			{
+				expect(TokenType::COMMA);
+				args.push_back(parse_expression());
+			}
+		}
+
+		expect(TokenType::RPAREN);
+
+		return args;
+	}
+
+	ExprNode* parse_expression(int min_precedence = 1)
+	{
+		auto left = parse_primary();
+
+		while (precedence(current().type) >= min_precedence)
+		{
+			TokenType op_type = current().type;
+			int op_precedence = precedence(op_type);
+			string_view op = expect(op_type).value;
+			VarType type = left->type.base_type;
+			VarType result_type = type;
+
+			if (op_type == TokenType::PLUS)
+			{
+				if (type == VarType::STRING || type == VarType::LIST)
+					include_type(left->type);
+				else if (type != VarType::INT && type != VarType::FLOAT)
+					throw runtime_error("Invalid Operand Types for '+' at Line " + to_string(current().line));
+			}
+			else if (op_type == TokenType::MINUS || op_type == TokenType::MULT || op_type == TokenType::DIV)
+			{
+				if (type != VarType::INT && type != VarType::FLOAT)
+					throw runtime_error("Invalid Operand Types for '" + string(op) + "' at Line " + to_string(current().line));
+
+				if (op_type == TokenType::DIV)
+					result_type = VarType::FLOAT;
+			}
+			else if (op_type == TokenType::AND || op_type == TokenType::OR)
+			{
+				if (type != VarType::BOOL)
+					throw runtime_error("Invalid Operand Types for '" + string(op) + "' at Line " + to_string(current().line));
+
+				op = op_type == TokenType::AND ? "&&" : "||";
+				result_type = VarType::BOOL;
+			}
+			else
+				result_type = VarType::BOOL;
+
+			//Left-associative: the right operand only absorbs tighter-binding operators
+			auto right = parse_expression(op_precedence + 1);
+			VarType right_type = right->type.base_type;
+
+			if (type != VarType::BOOL && right_type != VarType::BOOL &&
+				type != right_type && !(type == VarType::FLOAT && right_type == VarType::INT))
+				throw runtime_error("Type Mismatch in Operation at Line " + to_string(current().line));
+
+			if (type == VarType::STRING)
+			{
+				if (op_type == TokenType::PLUS)
+					include_string_op(StringMethod::CONCAT);
+				else if (op_type == TokenType::EQ || op_type == TokenType::NOTEQ)
+					include_string_op(StringMethod::EQUALS);
+				else
+					include_string_op(StringMethod::COMPARE);
+			}
+
+			CollectionType node_type = left->type;
+			node_type.base_type = result_type;
+
+			left = arena.make<BinOpNode>(op, left, right, node_type);
+		}
+
+		return left;
+	}
+
+	ExprNode* parse_primary()
+	{
+		if (current().type == TokenType::NUMBER)
+			return arena.make<LiteralNode>(save(expect(TokenType::NUMBER)), CollectionType{ VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE });
+		else if (current().type == TokenType::FLOATING)
+			return arena.make<LiteralNode>(save(expect(TokenType::FLOATING)), CollectionType{ VarType::FLOAT, VarType::NONE, VarType::NONE, VarType::NONE });
+		else if (current().type == TokenType::STRING_LITERAL)
+			return arena.make<LiteralNode>(save(expect(TokenType::STRING_LITERAL)), CollectionType{ VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE });
+		else if (current().type == TokenType::TRUE || current().type == TokenType::FALSE)
+			return arena.make<LiteralNode>(save(expect(current().type)), CollectionType{ VarType::BOOL, VarType::NONE, VarType::NONE, VarType::NONE });
+		else if (current().type == TokenType::IDENTIFIER && peek().type == TokenType::LPAREN)
+		{
+			uint32_t func_name_symbol = current().symbol;
+			string_view func_name = save(expect(TokenType::IDENTIFIER));
+			expect(TokenType::LPAREN);
+			auto args = parse_arguments();
+
+			const FunctionSignature* function = find_function(func_name_symbol);
+
+			if (!function)
+				throw runtime_error("Undefined function " + string(func_name) + " at line " + to_string(current().line));
+
+			note_call(func_name, *function);
+
+			return arena.make<CallExprNode>(func_name, move(args), function->return_type);
+		}
+		else if (current().type == TokenType::IDENTIFIER && peek().type == TokenType::LBRACKET)
+		{
+			uint32_t var_symbol = current().symbol;
+			string_view var = save(expect(TokenType::IDENTIFIER));
+			expect(TokenType::LBRACKET);
+			auto index = parse_expression();
+			expect(TokenType::RBRACKET);
+
+			const CollectionType* found = find_variable(var_symbol);
+
+			if (!found)
+				throw runtime_error("Undefined Variable " + string(var) + " at Line " + to_string(current().line));
+
+			CollectionType var_type = *found;
+			VarType result_type;
+
+			if (var_type.base_type == VarType::LIST || var_type.base_type == VarType::TUPLE)
+				result_type = var_type.element_type;
+			else if (var_type.base_type == VarType::DICT)
+				result_type = var_type.value_type;
+			else
+				throw runtime_error("Indexing Only Supported for Lists, Tuples, and Dicts at Line " + to_string(current().line));
+
+			include_type(var_type);
+
+			return arena.make<IndexNode>(var, var_type, index, CollectionType{ result_type, VarType::NONE, VarType::NONE, VarType::NONE });
+		}
+		else if (current().type == TokenType::IDENTIFIER && peek().type == TokenType::DOT)
+		{
+			uint32_t var_symbol = current().symbol;
+			string_view var = save(expect(TokenType::IDENTIFIER));
+			expect(TokenType::DOT);
+			string_view method = save(expect(TokenType::CALL_METHOD));
+			expect(TokenType::LPAREN);
+			auto args = parse_arguments();
+
+			const CollectionType* found = find_variable(var_symbol);
+
+			if (!found)
+				throw runtime_error("Undefined Variable " + string(var) + " at Line " + to_string(current().line));
+
+			CollectionType var_type = *found;
+
+			return arena.make<MethodExprNode>(var, method, var_type, move(args), method_return_type(method, var_type));
+		}
+		else if (current().type == TokenType::IDENTIFIER)
+		{
+			uint32_t var_symbol = current().symbol;
+			string_view var = save(expect(TokenType::IDENTIFIER));
+
+			const Binding* binding = find_binding(var_symbol);
+
+			if (!binding)
+				throw runtime_error("Undefined Variable " + string(var) + " at Line " + to_string(current().line));
+
+			include_type(binding->type);
+
+			return arena.make<VarNode>(var, binding->type, binding->constant);
+		}
+		else if (current().type == TokenType::FSTRING_START)
+			return parse_fstring();
+		else if (current().type == TokenType::LBRACKET)
+		{
+			expect(TokenType::LBRACKET);
+			ExprList elements(arena);
+			CollectionType list_type;
+
+			if (current().type != TokenType::RBRACKET)
+			{
+				elements.push_back(parse_expression());
+				list_type.element_type = elements.back()->type.base_type;
+
+				while (current().type == TokenType::COMMA)
+				{
+					expect(TokenType::COMMA);
+					elements.push_back(parse_expression());
+
+					if (elements.back()->type.base_type != list_type.element_type)
+						throw runtime_error("Inconsistent List Element Types at Line " + to_string(current().line));
+				}
+			}
+
+			expect(TokenType::RBRACKET);
+			list_type.base_type = VarType::LIST;
+			include_type(list_type);
+
+			return arena.make<ListNode>(move(elements), list_type);
+		}
+		else if (current().type == TokenType::LPAREN)
+		{
+			expect(TokenType::LPAREN);
+			ExprList elements(arena);
+			CollectionType tuple_type;
+
+			if (current().type != TokenType::RPAREN)
+			{
+				elements.push_back(parse_expression());
+				tuple_type.element_type = elements.back()->type.base_type;
+
+				while (current().type == TokenType::COMMA)
+				{
+					expect(TokenType::COMMA);
+					elements.push_back(parse_expression());
+
+					if (elements.back()->type.base_type != tuple_type.element_type)
+						throw runtime_error("Inconsistent tuple element types at line " + to_string(current().line));
+				}
+			}
+
+			expect(TokenType::RPAREN);
+			tuple_type.base_type = VarType::TUPLE;
+			include_type(tuple_type);
+
+			return arena.make<TupleNode>(move(elements), tuple_type);
+		}
+		else if (current().type == TokenType::LBRACE)
+		{
+			expect(TokenType::LBRACE);
+			ArenaVector<pair<ExprNode*, ExprNode*>> entries(arena);
+			CollectionType dict_type;
+
+			while (current().type != TokenType::RBRACE)
+			{
+				if (!entries.empty())
+					expect(TokenType::COMMA);
+
+				auto key = parse_expression();
+
+				if (key->type.base_type != VarType::STRING)
+					throw runtime_error("Dictionary Key Must be a String at Line " + to_string(current().line));
+
+				expect(TokenType::COLON);
+				auto value = parse_expression();
+
+				if (entries.empty())
+				{
+					dict_type.key_type = VarType::STRING;
+					dict_type.value_type = value->type.base_type;
+				}
+				else if (value->type.base_type != dict_type.value_type)
+					throw runtime_error("Inconsistent Dictionary Value Types at Line " + to_string(current().line));
+
+				entries.emplace_back(key, value);
+			}
+
+			expect(TokenType::RBRACE);
+			dict_type.base_type = VarType::DICT;
+			include_type(dict_type);
+
+			return arena.make<DictNode>(move(entries), dict_type);
+		}
+		else if (current().type == TokenType::LEN)
+		{
+			expect(TokenType::LEN);
+			expect(TokenType::LPAREN);
+			auto expr = parse_expression();
+			expect(TokenType::RPAREN);
+
+			if (!is_heap_type(expr->type.base_type))
+				throw runtime_error("LEN Function Only Supported for Strings, Lists, Tuples, and Dicts at Line " + to_string(current().line));
+
+			include_type(expr->type);
+
+			return arena.make<LenNode>(expr);
+		}
+		else
+			throw runtime_error("Invalid Expression at Line " + to_string(current().line));
+	}
+
+	ExprNode* parse_fstring()
+	{
+		expect(TokenType::FSTRING_START);
+		include_string_op(StringMethod::FORMAT);
+
+		ArenaVector<FStringPiece> pieces(arena);
+
+		while (current().type != TokenType::FSTRING_END)
+		{
+			if (current().type == TokenType::STRING_LITERAL)
+				pieces.push_back({ arena.copy_string(expect(TokenType::STRING_LITERAL).value), nullptr, string_view() });
+			else if (current().type == TokenType::FSTRING_EXPR_START)
+			{
+				expect(TokenType::FSTRING_EXPR_START);
+
+				auto expr = parse_expression();
+				VarType type = expr->type.base_type;
+				include_printed(expr->type);
+
+				string_view conversion;
+
+				if (current().type == TokenType::FSTRING_FORMAT_SPEC)
+				{
+					string_view format_spec = expect(TokenType::FSTRING_FORMAT_SPEC).value;
+					FormatSpec spec;
+					size_t i = 0;
+
+					if (format_spec[i] == '<' || format_spec[i] == '>' || format_spec[i] == '^')
+					{
+						spec.alignment = format_spec[i];
+						i++;
+					}
+
+					while (i < format_spec.size() && isdigit(format_spec[i]))
+					{
+						spec.width += format_spec[i];
+						i++;
+					}
+
+					if (i < format_spec.size() && format_spec[i] == '.')
+					{
+						i++;
+
+						while (i < format_spec.size() && isdigit(format_spec[i]))
+						{
+							spec.precision += format_spec[i];
+							i++;
+						}
+					}
+
+					//Without an explicit type the value's own conversion is used
+					if (i < format_spec.size())
+						spec.type = format_spec[i];
+					else
+						spec.type = type == VarType::INT ? 'd' : type == VarType::FLOAT ? 'f' : 's';
+
+					string format_str;
+
+					if (!spec.alignment.empty())
+						format_str += spec.alignment;
+
+					if (!spec.width.empty())
+						format_str += spec.width;
+
+					if (!spec.precision.empty())
+						format_str += "." + spec.precision;
+
+					format_str += spec.type;
+					conversion = arena.copy_string("%" + format_str);
+				}
+
+				pieces.push_back({ string_view(), expr, conversion });
+
+				expect(TokenType::FSTRING_EXPR_END);
+			}
+			else
+				throw runtime_error("Invalid F-String at Line " + to_string(current().line));
+		}
+
+		expect(TokenType::FSTRING_END);
+
+		return arena.make<FStringNode>(move(pieces));
+	}
+
+	CollectionType method_return_type(string_view method, const CollectionType& var_type)
+	{
+		if (var_type.base_type != VarType::STRING && var_type.base_type != VarType::LIST)
+			throw runtime_error("Method Call Only Supported for Strings and Lists at Line " + to_string(current().line));
+
+		if (method == "append")
+		{
+			if (var_type.base_type != VarType::LIST)
+				throw runtime_error("'Append' Method Only Supported for Lists at Line " + to_string(current().line));
+
+			include_method(method, var_type);
+
+			return{ VarType::NONE, VarType::NONE, VarType::NONE, VarType::NONE };
+		}
+		else if (method == "upper" || method == "lower" || method == "strip" || method == "replace" ||
+			method == "split" || method == "find")
+		{
+			if (var_type.base_type != VarType::STRING)
+				throw runtime_error("'String' Methods Only Supported for Strings at Line " + to_string(current().line));
+
+			include_method(method, var_type);
+
+			if (method == "split")
+			{
+				return{ VarType::LIST, VarType::STRING, VarType::NONE, VarType::NONE };
+			}
+			else if (method == "find")
+				return{ VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE };
+			else
+				return{ VarType::STRING, VarType::NONE, VarType::NONE, VarType::NONE };
+		}
+		else
+			throw runtime_error("Unsupported Method " + string(method) + " at Line " + to_string(current().line));
+	}
+
+	ASTNode* parse_assignment()
+	{
+		CollectionType type = parse_collection_type();
+		uint32_t var_symbol = current().symbol;
+		string_view var = save(expect(TokenType::IDENTIFIER));
+		expect(TokenType::EQUALS);
+		auto expr = parse_expression();
+		VarType expr_base = expr->type.base_type;
+		const CollectionType& expr_type = expr->type;
+
+		if (type.base_type == VarType::INT && expr_base != VarType::INT)
+			throw runtime_error("Type Mismatch in Assignment at Line " + to_string(current().line));
+
+		if (type.base_type == VarType::FLOAT && expr_base != VarType::FLOAT && expr_base != VarType::INT)
+			throw runtime_error("Type Mismatch in Assignment at Line " + to_string(current().line));
+
+		if (type.base_type == VarType::STRING && expr_base != VarType::STRING)
+			throw runtime_error("Type Mismatch in Assignment at Line " + to_string(current().line));
+
+		if (type.base_type == VarType::BOOL && expr_base != VarType::BOOL)
+			throw runtime_error("Type Mismatch in Assignment at Line " + to_string(current().line));
+
+		if (type.base_type == VarType::LIST && (expr_base != VarType::LIST || type.element_type != expr_type.element_type))
+			throw runtime_error("Type Mismatch in List Assignment at Line " + to_string(current().line));
+
+		if (type.base_type == VarType::TUPLE && (expr_base != VarType::TUPLE || type.element_type != expr_type.element_type))
+			throw runtime_error("Type Mismatch in Tuple Assignment at Line " + to_string(current().line));
+
+		if (type.base_type == VarType::DICT && (expr_base != VarType::DICT ||
+			type.key_type != expr_type.key_type || type.value_type != expr_type.value_type))
+			throw runtime_error("Type Mismatch in Dict Assignment at Line " + to_string(current().line));
+
+		Binding* binding = find_binding(var_symbol);
+		bool is_declaration = !binding;
+		bool release_previous = false;
+
+		//A heap value held by another variable is copied or moved, so the variable always owns its value
+		if (is_declaration)
+			declare_variable(var_symbol, type, true);
+		else
+		{
+			if (!binding->owned && is_heap_type(binding->type.base_type))
+				adopt_parameter(var_symbol, *binding);
+
+			release_previous = binding->owned;
+			binding->type = type;
+
+			if (binding->constant)
+				binding->constant->reassigned = true;
+		}
+
+		expect(TokenType::NEWLINE);
+
+		auto node = arena.make<AssignNode>(var, expr, type, is_declaration, release_previous);
+		propose_move(node, var_symbol);
+
+		//Scalars and strings can be propagated; collections are mutated in place
+		if (is_declaration && (type.base_type == VarType::STRING || !is_heap_type(type.base_type)))
+		{
+			node->constant = arena.make<ConstantSlot>();
+			variables[var_symbol].constant = node->constant;
+		}
+
+		return node;
+	}
+
+	ASTNode* parse_function()
+	{
+		Hasher body_hash;
+		RuntimeFeatures unit_runtime;
+		token_hash = &body_hash;
+		function_runtime = &unit_runtime;
+
+		expect(TokenType::DEF);
+
+		uint32_t name_symbol = current().symbol;
+		string_view name = save(expect(TokenType::IDENTIFIER));
+
+		expect(TokenType::LPAREN);
+
+		LocalList args(arena);
+		vector<uint32_t> arg_symbols;
+		vector<CollectionType> arg_types;
+
+		if (current().type != TokenType::RPAREN)
+		{
+			CollectionType type = parse_collection_type();
+			uint32_t arg_name_symbol = current().symbol;
+			string_view arg_name = save(expect(TokenType::IDENTIFIER));
+
+			args.emplace_back(arg_name, type);
+			arg_symbols.push_back(arg_name_symbol);
+			arg_types.push_back(type);
+
+			while (current().type == TokenType::COMMA)
+			{
+				expect(TokenType::COMMA);
+
+				type = parse_collection_type();
+				arg_name_symbol = current().symbol;
+				arg_name = save(expect(TokenType::IDENTIFIER));
+
+				args.emplace_back(arg_name, type);
+				arg_symbols.push_back(arg_name_symbol);
+				arg_types.push_back(type);
+			}
+		}
+
+		expect(TokenType::RPAREN);
+
+		CollectionType return_type = { VarType::NONE, VarType::NONE, VarType::NONE, VarType::NONE };
+
+		if (current().type == TokenType::COLON && peek().type != TokenType::NEWLINE)
+		{
+			expect(TokenType::COLON);
+
+			return_type = parse_collection_type();
+		}
+
+		expect(TokenType::COLON);
+		expect(TokenType::NEWLINE);
+		expect(TokenType::INDENT);
+
+		declare_function(name_symbol, arg_types, return_type);
+
+		auto func = arena.make<FunctionNode>(name, move(args), return_type, arena);
+
+		//Arguments belong to the caller; module variables are not visible inside
+		push_scope(ScopeKind::FUNCTION, func->body.owned);
+		current_function = func;
+		vector<ReturnNode*> outer_returns;
+		function_returns.swap(outer_returns);
+
+		for (size_t i = 0; i < arg_symbols.size(); ++i)
+			declare_variable(arg_symbols[i], arg_types[i], false);
+
+		parse_body(func->body);
+		pop_scope();
+		function_returns.swap(outer_returns);
+
+		func->cache_key = body_hash.value();
+		func->runtime = unit_runtime;
+		current_function = nullptr;
+		token_hash = nullptr;
+		function_runtime = nullptr;
+
+		return func;
+	}
+
+	ASTNode* parse_function_call()
+	{
+		uint32_t func_name_symbol = current().symbol;
+		string_view func_name = save(expect(TokenType::IDENTIFIER));
+
+		expect(TokenType::LPAREN);
+
+		auto args = parse_arguments();
+
+		expect(TokenType::NEWLINE);
+
+		const FunctionSignature* function = find_function(func_name_symbol);
+
+		if (!function)
+			throw runtime_error("Undefined Function " + string(func_name) + " at Line " + to_string(current().line));
+
+		note_call(func_name, *function);
+
+		return arena.make<CallNode>(func_name, move(args), function->return_type);
+	}
+
+	ASTNode* parse_method_call()
+	{
+		uint32_t var_symbol = current().symbol;
+		string_view var = save(expect(TokenType::IDENTIFIER));
+		expect(TokenType::DOT);
+		string_view method = save(expect(TokenType::CALL_METHOD));
+		expect(TokenType::LPAREN);
+		auto args = parse_arguments();
+		expect(TokenType::NEWLINE);
+
+		const CollectionType* found = find_variable(var_symbol);
+
+		if (!found)
+			throw runtime_error("Undefined Variable " + string(var) + " at Line " + to_string(current().line));
+
+		CollectionType var_type = *found;
+		CollectionType return_type = method_return_type(method, var_type);
+
+		return arena.make<MethodCallNode>(var, method, move(args), var_type, return_type);
+	}
+
+	ASTNode* parse_return()
+	{
+		expect(TokenType::RETURN);
+		auto expr = parse_expression();
+		expect(TokenType::NEWLINE);
+
+		auto node = arena.make<ReturnNode>(expr, live_locals());
+		function_returns.push_back(node);
+
+		return node;
+	}
+
+	ASTNode* parse_print()
+	{
+		expect(TokenType::PRINT);
+		expect(TokenType::LPAREN);
+
+		ExprList values(arena);
+		string_view separator = " ";
+
+		if (current().type != TokenType::RPAREN)
+		{
+			values.push_back(parse_expression());
+			include_print(values.back()->type);
+
+			while (current().type == TokenType::COMMA)
+			{
+				expect(TokenType::COMMA);
+
+				if (current().type == TokenType::SEP)
+				{
+					expect(TokenType::SEP);
+					expect(TokenType::EQUALS);
+
+					if (current().type != TokenType::STRING_LITERAL)
+						throw runtime_error("Separator Must be a String at Line " + to_string(current().line));
+
+					separator = save(expect(TokenType::STRING_LITERAL));
+
+					break;
+				}
+
+				values.push_back(parse_expression());
+				include_print(values.back()->type);
+			}
+		}
+
+		expect(TokenType::RPAREN);
+		expect(TokenType::NEWLINE);
+
+		//An empty print still writes a line
+		if (values.empty())
+			include_print({ VarType::NONE, VarType::NONE, VarType::NONE, VarType::NONE });
+
+		return arena.make<PrintNode>(move(values), separator);
+	}
+
+	ASTNode* parse_if()
+	{
+		expect(TokenType::IF);
+
+		auto condition = parse_expression();
+
+		expect(TokenType::COLON);
+		expect(TokenType::NEWLINE);
+		expect(TokenType::INDENT);
+
+		auto if_node = arena.make<IfNode>(condition, arena);
+
+		parse_block(if_node->body);
+
+		while (current().type == TokenType::ELIF)
+		{
+			expect(TokenType::ELIF);
+
+			auto elif_condition = parse_expression();
+
+			expect(TokenType::COLON);
+			expect(TokenType::NEWLINE);
+			expect(TokenType::INDENT);
+
+			Block elif_body(arena);
+			parse_block(elif_body);
+
+			if_node->elif_clauses.emplace_back(elif_condition, move(elif_body));
+		}
+
+		if (current().type == TokenType::ELSE)
+		{
+			expect(TokenType::ELSE);
+			expect(TokenType::COLON);
+			expect(TokenType::NEWLINE);
+			expect(TokenType::INDENT);
+
+			parse_block(if_node->else_body);
+		}
+
+		return if_node;
+	}
+
+	ASTNode* parse_for()
+	{
+		expect(TokenType::FOR);
+		uint32_t var_symbol = current().symbol;
+		string_view var = save(expect(TokenType::IDENTIFIER));
+		expect(TokenType::IN);
+		expect(TokenType::RANGE);
+		expect(TokenType::LPAREN);
+
+		auto start = parse_expression();
+
+		expect(TokenType::COMMA);
+
+		auto end = parse_expression();
+
+		expect(TokenType::RPAREN);
+		expect(TokenType::COLON);
+		expect(TokenType::NEWLINE);
+		expect(TokenType::INDENT);
+
+		auto for_node = arena.make<ForNode>(var, start, end, arena);
+
+		//The loop variable is scoped to the body, as in the generated C
+		push_scope(ScopeKind::BLOCK, for_node->body.owned);
+		declare_variable(var_symbol, { VarType::INT, VarType::NONE, VarType::NONE, VarType::NONE }, false);
+		parse_body(for_node->body);
+		pop_scope();
+
+		return for_node;
+	}
+
+	ASTNode* parse_while()
+	{
+		expect(TokenType::WHILE);
+
+		auto condition = parse_expression();
+
+		expect(TokenType::COLON);
+		expect(TokenType::NEWLINE);
+		expect(TokenType::INDENT);
+
+		auto while_node = arena.make<WhileNode>(condition, arena);
+
+		parse_block(while_node->body);
+
+		return while_node;
+	}
+
+	ASTNode* parse_match()
+	{
+		expect(TokenType::MATCH);
+		auto expr = parse_expression();
+
+		if (expr->type.base_type != VarType::INT && expr->type.base_type != VarType::BOOL)
+			throw runtime_error("Match expression must be int or bool at line " + to_string(current().line));
+
+		expect(TokenType::COLON);
+		expect(TokenType::NEWLINE);
+		expect(TokenType::INDENT);
+
+		auto match_node = arena.make<MatchNode>(expr, arena);
+
+		while (current().type == TokenType::CASE)
+		{
+			expect(TokenType::CASE);
+			string_view pattern = "_";
+
+			if (current().type == TokenType::NUMBER)
+				pattern = save(expect(TokenType::NUMBER));
+			else if (current().type == TokenType::TRUE || current().type == TokenType::FALSE)
+				pattern = save(expect(current().type));
+			else if (current().type == TokenType::IDENTIFIER && current().value == "_")
+				expect(TokenType::IDENTIFIER);
+
+			expect(TokenType::COLON);
+			expect(TokenType::NEWLINE);
+			expect(TokenType::INDENT);
+
+			Block case_body(arena);
+			parse_block(case_body);
+
+			if (pattern == "_")
+				match_node->default_case = move(case_body);
+			else
+				match_node->cases.emplace_back(pattern, move(case_body));
+		}
+
+		expect(TokenType::DEDENT);
+
+		return match_node;
+	}
+
+	ASTNode* parse_index_assignment()
+	{
+		uint32_t var_symbol = current().symbol;
+		string_view var = save(expect(TokenType::IDENTIFIER));
+		expect(TokenType::LBRACKET);
+
+		auto index = parse_expression();
+
+		expect(TokenType::RBRACKET);
+		expect(TokenType::EQUALS);
+
+		auto value = parse_expression();
+
+		expect(TokenType::NEWLINE);
+
+		const CollectionType* found = find_variable(var_symbol);
+
+		if (!found)
+			throw runtime_error("Undefined Variable " + string(var) + " at Line " + to_string(current().line));
+
+		CollectionType var_type = *found;
+
+		if (var_type.base_type != VarType::LIST && var_type.base_type != VarType::DICT)
+			throw runtime_error("Indexing Only Supported for Lists and Dicts at Line " + to_string(current().line));
+
+		if (var_type.base_type == VarType::LIST && index->type.base_type != VarType::INT)
+			throw runtime_error("List Index Must be an Integer at Line " + to_string(current().line));
+
+		if (var_type.base_type == VarType::DICT && index->type.base_type != VarType::STRING)
+			throw runtime_error("Dict Index Must be a String at Line " + to_string(current().line));
+
+		if (var_type.base_type == VarType::LIST && var_type.element_type != value->type.base_type)
+			throw runtime_error("Type Mismatch in List Assignment at Line " + to_string(current().line));
+
+		if (var_type.base_type == VarType::DICT && var_type.value_type != value->type.base_type)
+			throw runtime_error("Type Mismatch in Dict Assignment at Line " + to_string(current().line));
+
+		include_type(var_type);
+
+		return arena.make<IndexAssignNode>(var, var_type, index, value);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,1148 @@
+#pragma once
+#include <string>
+#include "ASTNodes.h"
+
+using namespace std;
+
+//---RUNTIME---
+//Support code for generated programs, emitted into the program itself instead of being included from
+//headers. Every container is monomorphized for the element types the program actually uses, and every
+//function is static inline so the C compiler can inline container operations into user loops.
+//What to emit is recorded in RuntimeFeatures (ASTNodes.h) while parsing.
+
+//Templates are written once with placeholders: $S type suffix (int, string, ...), $T C element type,
+//$F releases an element the container owns and $C copies one (only strings hold anything to
+//release or copy)
+inline string specialize(const char* code, VarType type)
+{
+	string suffix = vartype_to_c(type);
+	string element = c_type({ type, VarType::NONE, VarType::NONE, VarType::NONE });
+	string release = type == VarType::STRING ? "free_string" : "(void)";
+	string copy = type == VarType::STRING ? "string_copy" : "";
+	string result;
+
+	for (const char* c = code; *c; ++c)
+	{
+		if (c[0] == '$' && (c[1] == 'S' || c[1] == 'T' || c[1] == 'F' || c[1] == 'C'))
+		{
+			result += c[1] == 'S' ? suffix : c[1] == 'T' ? element : c[1] == 'F' ? release : copy;
+			++c;
+		}
+		else
+			result += *c;
+	}
+
+	return result;
+}
+
+//Strings carry their length, so len() is O(1) and copies are a single memcpy. Data is always
+//NUL-terminated. Strings shorter than STRING_SMALL are stored inline with no heap allocation.
+//Capacity 0 marks a borrowed buffer (an interned literal, or a piece of another string's storage)
+//that is never written or freed; writing to one copies it first.
+//Program output collects in one large buffer that only the program's own thread writes, so printing
+//takes no lock. It is handed to stdio when full, when main() returns, before an error message, and
+//after every line when line_buffered is set. The buffer is a weak definition, so all translation
+//units of an incremental build share one.
+const char* const RUNTIME_COMMON = R"C(#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING_SMALL 16
+#define STRING_INLINE -1
+
+typedef struct
+{
+    union
+    {
+        char* heap;
+        char small[STRING_SMALL];
+    };
+    int length;
+    int capacity;
+} String;
+
+#define string_data(s) ((s).capacity == STRING_INLINE ? (s).small : (s).heap)
+#define string_literal(s) ((String){ { (char*)(s) }, (int)sizeof(s) - 1, 0 })
+
+static inline String string_borrow(const char* data, int length)
+{
+    String s = { { (char*)data }, length, 0 };
+    return s;
+}
+
+static inline int string_capacity(const String* s)
+{
+    return s->capacity == STRING_INLINE ? STRING_SMALL : s->capacity;
+}
+
+//Contents are left for the caller to fill in
+static inline String string_alloc(int length)
+{
+    String s;
+    s.length = length;
+
+    if (length < STRING_SMALL)
+        s.capacity = STRING_INLINE;
+    else
+    {
+        s.heap = (char*)malloc(length + 1);
+        s.capacity = length + 1;
+    }
+
+    return s;
+}
+
+static inline String string_from(const char* data, int length)
+{
+    String s = string_alloc(length);
+    char* target = string_data(s);
+    memcpy(target, data, length);
+    target[length] = '\0';
+    return s;
+}
+
+static inline String string_copy(String s)
+{
+    return string_from(string_data(s), s.length);
+}
+
+static inline void free_string(String s)
+{
+    if (s.capacity > 0)
+        free(s.heap);
+}
+
+//Hands the value over and leaves the source empty and borrowed, so releasing it is a no-op
+static inline String string_move(String* s)
+{
+    String value = *s;
+    *s = string_literal("");
+    return value;
+}
+
+static inline void string_assign(String* target, String value)
+{
+    if (string_capacity(target) > value.length)
+    {
+        char* data = string_data(*target);
+        memmove(data, string_data(value), value.length);
+        data[value.length] = '\0';
+        target->length = value.length;
+        return;
+    }
+
+    String copy = string_copy(value);
+    free_string(*target);
+    *target = copy;
+}
+
+#define MINIPY_OUTPUT_SIZE (1 << 16)
+
+typedef struct
+{
+    char data[MINIPY_OUTPUT_SIZE];
+    int size;
+    int line_buffered;
+} MinipyOutput;
+
+#ifdef _MSC_VER
+__declspec(selectany) MinipyOutput minipy_output = { { 0 }, 0, 0 };
+#else
+__attribute__((weak)) MinipyOutput minipy_output = { { 0 }, 0, 0 };
+#endif
+
+static inline void minipy_flush(void)
+{
+    fwrite(minipy_output.data, 1, minipy_output.size, stdout);
+    minipy_output.size = 0;
+    fflush(stdout);
+}
+
+static inline void minipy_write(const char* data, int length)
+{
+    if (minipy_output.size + length > MINIPY_OUTPUT_SIZE)
+    {
+        fwrite(minipy_output.data, 1, minipy_output.size, stdout);
+        minipy_output.size = 0;
+
+        if (length > MINIPY_OUTPUT_SIZE)
+        {
+            fwrite(data, 1, length, stdout);
+            return;
+        }
+    }
+
+    memcpy(minipy_output.data + minipy_output.size, data, length);
+    minipy_output.size += length;
+}
+)C";
+
+//Appends grow the buffer geometrically, so building a string piece by piece is amortized linear
+const char* const RUNTIME_STRING_CONCAT = R"C(
+static inline void string_reserve(String* s, int length)
+{
+    int current = string_capacity(s);
+
+    if (current > length)
+        return;
+
+    if (s->capacity == 0 && length < STRING_SMALL)
+    {
+        *s = string_from(s->heap, s->length);
+        return;
+    }
+
+    int capacity = current > STRING_SMALL ? current : STRING_SMALL;
+
+    while (capacity <= length)
+        capacity *= 2;
+
+    if (s->capacity > 0)
+        s->heap = (char*)realloc(s->heap, capacity);
+    else
+    {
+        char* data = (char*)malloc(capacity);
+        memcpy(data, string_data(*s), s->length + 1);
+        s->heap = data;
+    }
+
+    s->capacity = capacity;
+}
+
+static inline void string_append(String* target, String value)
+{
+    int self = target->capacity > 0 && value.capacity > 0 && value.heap == target->heap;
+    string_reserve(target, target->length + value.length);
+
+    if (self)
+        value.heap = target->heap;
+
+    char* data = string_data(*target);
+    memcpy(data + target->length, string_data(value), value.length);
+    target->length += value.length;
+    data[target->length] = '\0';
+}
+
+static inline String string_concat(String a, String b)
+{
+    String result = string_alloc(a.length + b.length);
+    char* data = string_data(result);
+    memcpy(data, string_data(a), a.length);
+    memcpy(data + a.length, string_data(b), b.length);
+    data[result.length] = '\0';
+    return result;
+}
+)C";
+
+//f-strings start from a buffer sized for every piece of known length and append the rest, growing
+//as needed, so results are never truncated. Numbers without a format spec skip printf.
+const char* const RUNTIME_STRING_FORMAT = R"C(
+#include <stdarg.h>
+
+static inline String string_builder(int length)
+{
+    String s = string_from("", 0);
+    string_reserve(&s, length);
+    return s;
+}
+
+static inline void string_append_text(String* s, const char* text)
+{
+    string_append(s, string_borrow(text, (int)strlen(text)));
+}
+
+static inline void string_append_int(String* s, int value)
+{
+    string_reserve(s, s->length + 11);
+    char* data = string_data(*s);
+    s->length += minipy_format_int(data + s->length, value);
+    data[s->length] = '\0';
+}
+
+static inline void string_append_float(String* s, float value)
+{
+    string_reserve(s, s->length + MINIPY_FLOAT_SIZE);
+    char* data = string_data(*s);
+    s->length += minipy_format_float(data + s->length, value);
+    data[s->length] = '\0';
+}
+
+//Formats straight into the spare capacity, retrying once with room for the full result
+static inline void string_append_format(String* s, const char* format, ...)
+{
+    va_list args;
+    int room = s->capacity ? string_capacity(s) - s->length : 0;
+
+    va_start(args, format);
+    int length = vsnprintf(string_data(*s) + s->length, room, format, args);
+    va_end(args);
+
+    if (length >= room)
+    {
+        string_reserve(s, s->length + length);
+        va_start(args, format);
+        vsnprintf(string_data(*s) + s->length, length + 1, format, args);
+        va_end(args);
+    }
+
+    s->length += length;
+}
+)C";
+
+const char* const RUNTIME_STRING_EQUALS = R"C(
+static inline int string_equals(String a, String b)
+{
+    return a.length == b.length && memcmp(string_data(a), string_data(b), a.length) == 0;
+}
+)C";
+
+const char* const RUNTIME_STRING_COMPARE = R"C(
+static inline int string_compare(String a, String b)
+{
+    int length = a.length < b.length ? a.length : b.length;
+    int result = memcmp(string_data(a), string_data(b), length);
+    return result ? result : a.length - b.length;
+}
+)C";
+
+//Number formatters shared by print, f-strings and container text. Each writes into a buffer with
+//room for its longest result and returns the length; no format string is interpreted at runtime.
+const char* const RUNTIME_FORMAT_INT = R"C(
+static const char minipy_digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+//Two digits per division, written backwards from the end of a scratch buffer
+static inline int minipy_format_unsigned(char* buffer, unsigned long long value)
+{
+    char digits[20];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+
+    while (value >= 100)
+    {
+        const char* pair = minipy_digit_pairs + (value % 100) * 2;
+        value /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+
+    if (value >= 10)
+    {
+        *--p = minipy_digit_pairs[value * 2 + 1];
+        *--p = minipy_digit_pairs[value * 2];
+    }
+    else
+        *--p = (char)('0' + value);
+
+    memcpy(buffer, p, end - p);
+    return (int)(end - p);
+}
+
+//At most 11 characters
+static inline int minipy_format_int(char* buffer, int value)
+{
+    if (value >= 0)
+        return minipy_format_unsigned(buffer, (unsigned)value);
+
+    buffer[0] = '-';
+    return 1 + minipy_format_unsigned(buffer + 1, 0u - (unsigned)value);
+}
+)C";
+
+//Same digits as printf("%f"). A float times 1e6 is exact in a double, so rounding that product to
+//an integer (to nearest, ties to even, as printf does) yields all six decimals at once. Values too
+//large for the shortcut, infinities and NaN fall back to snprintf. At most 64 characters.
+const char* const RUNTIME_FORMAT_FLOAT = R"C(
+#define MINIPY_FLOAT_SIZE 64
+
+static inline int minipy_format_float(char* buffer, float value)
+{
+    double scaled = (double)value * 1e6;
+
+    if (!(scaled > -9e15 && scaled < 9e15))
+        return snprintf(buffer, MINIPY_FLOAT_SIZE, "%f", value);
+
+    unsigned bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    int length = 0;
+    double magnitude = scaled < 0 ? -scaled : scaled;
+    unsigned long long units = (unsigned long long)magnitude;
+    double rest = magnitude - (double)units;
+
+    if (rest > 0.5 || (rest == 0.5 && (units & 1)))
+        units++;
+
+    if (bits >> 31)
+        buffer[length++] = '-';
+
+    length += minipy_format_unsigned(buffer + length, units / 1000000);
+    buffer[length++] = '.';
+
+    unsigned decimals = (unsigned)(units % 1000000);
+
+    for (int i = 5; i >= 0; i--)
+    {
+        buffer[length + i] = (char)('0' + decimals % 10);
+        decimals /= 10;
+    }
+
+    return length + 6;
+}
+)C";
+
+//Growable text used to build to_string results. Results rotate through a few scratch buffers, so
+//several can appear in one printf; each stays valid until eight more have been built.
+const char* const RUNTIME_TEXT = R"C(
+typedef struct
+{
+    char* data;
+    int size;
+    int capacity;
+} MinipyText;
+
+static MinipyText minipy_scratch[8];
+static int minipy_scratch_next;
+
+static inline void minipy_text_reserve(MinipyText* text, int extra)
+{
+    if (text->size + extra + 1 <= text->capacity)
+        return;
+
+    while (text->size + extra + 1 > text->capacity)
+        text->capacity = text->capacity ? text->capacity * 2 : 64;
+
+    text->data = (char*)realloc(text->data, text->capacity);
+}
+
+static inline MinipyText* minipy_text_begin(void)
+{
+    MinipyText* text = &minipy_scratch[minipy_scratch_next++ & 7];
+    text->size = 0;
+    minipy_text_reserve(text, 0);
+    text->data[0] = '\0';
+    return text;
+}
+
+static inline void minipy_text_append(MinipyText* text, const char* s, int length)
+{
+    minipy_text_reserve(text, length);
+    memcpy(text->data + text->size, s, length);
+    text->size += length;
+    text->data[text->size] = '\0';
+}
+)C";
+
+//Appends one element the way it appears inside a printed container
+const char* const RUNTIME_PUT_INT = R"C(
+static inline void minipy_text_put_int(MinipyText* text, int value)
+{
+    minipy_text_reserve(text, 11);
+    text->size += minipy_format_int(text->data + text->size, value);
+    text->data[text->size] = '\0';
+}
+)C";
+
+const char* const RUNTIME_PUT_FLOAT = R"C(
+static inline void minipy_text_put_float(MinipyText* text, float value)
+{
+    char buffer[32];
+    minipy_text_append(text, buffer, snprintf(buffer, sizeof(buffer), "%g", value));
+}
+)C";
+
+const char* const RUNTIME_PUT_BOOL = R"C(
+static inline void minipy_text_put_bool(MinipyText* text, int value)
+{
+    if (value)
+        minipy_text_append(text, "true", 4);
+    else
+        minipy_text_append(text, "false", 5);
+}
+)C";
+
+const char* const RUNTIME_PUT_STRING = R"C(
+static inline void minipy_text_put_string(MinipyText* text, String value)
+{
+    minipy_text_append(text, "'", 1);
+    minipy_text_append(text, string_data(value), value.length);
+    minipy_text_append(text, "'", 1);
+}
+)C";
+
+//Lists grow geometrically and own their elements; a copy owns copies of them. A list made by str_split holds pieces borrowed from its storage.
+const char* const RUNTIME_LIST = R"C(
+typedef struct
+{
+    $T* data;
+    int size;
+    int capacity;
+    char* storage;
+} List$S;
+
+static inline List$S* create_list_$S(int size)
+{
+    List$S* list = (List$S*)malloc(sizeof(List$S));
+    list->size = size;
+    list->capacity = size > 4 ? size : 4;
+    list->data = ($T*)malloc(sizeof($T) * list->capacity);
+    list->storage = NULL;
+    return list;
+}
+
+static inline void free_list_$S(List$S* list)
+{
+    if (!list)
+        return;
+
+    for (int i = 0; i < list->size; i++)
+        $F(list->data[i]);
+
+    free(list->storage);
+    free(list->data);
+    free(list);
+}
+
+static inline List$S* copy_list_$S(const List$S* list)
+{
+    List$S* copy = create_list_$S(list->size);
+
+    for (int i = 0; i < list->size; i++)
+        copy->data[i] = $C(list->data[i]);
+
+    return copy;
+}
+
+//Hands the list over and leaves the source NULL, so releasing it is a no-op
+static inline List$S* move_list_$S(List$S** list)
+{
+    List$S* value = *list;
+    *list = NULL;
+    return value;
+}
+)C";
+
+const char* const RUNTIME_LIST_APPEND = R"C(
+static inline void list_append_$S(List$S* list, $T value)
+{
+    if (list->size == list->capacity)
+    {
+        list->capacity *= 2;
+        list->data = ($T*)realloc(list->data, sizeof($T) * list->capacity);
+    }
+
+    list->data[list->size++] = value;
+}
+)C";
+
+const char* const RUNTIME_LIST_TO_STRING = R"C(
+static inline char* list_to_string_$S(const List$S* list)
+{
+    MinipyText* text = minipy_text_begin();
+    minipy_text_append(text, "[", 1);
+
+    for (int i = 0; i < list->size; i++)
+    {
+        if (i > 0)
+            minipy_text_append(text, ", ", 2);
+
+        minipy_text_put_$S(text, list->data[i]);
+    }
+
+    minipy_text_append(text, "]", 1);
+    return text->data;
+}
+)C";
+
+const char* const RUNTIME_TUPLE = R"C(
+typedef struct
+{
+    $T* data;
+    int size;
+} Tuple$S;
+
+static inline Tuple$S* create_tuple_$S(int size)
+{
+    Tuple$S* tuple = (Tuple$S*)malloc(sizeof(Tuple$S));
+    tuple->size = size;
+    tuple->data = ($T*)malloc(sizeof($T) * (size > 0 ? size : 1));
+    return tuple;
+}
+
+static inline void free_tuple_$S(Tuple$S* tuple)
+{
+    if (!tuple)
+        return;
+
+    for (int i = 0; i < tuple->size; i++)
+        $F(tuple->data[i]);
+
+    free(tuple->data);
+    free(tuple);
+}
+
+static inline Tuple$S* copy_tuple_$S(const Tuple$S* tuple)
+{
+    Tuple$S* copy = create_tuple_$S(tuple->size);
+
+    for (int i = 0; i < tuple->size; i++)
+        copy->data[i] = $C(tuple->data[i]);
+
+    return copy;
+}
+
+static inline Tuple$S* move_tuple_$S(Tuple$S** tuple)
+{
+    Tuple$S* value = *tuple;
+    *tuple = NULL;
+    return value;
+}
+)C";
+
+const char* const RUNTIME_TUPLE_TO_STRING = R"C(
+static inline char* tuple_to_string_$S(const Tuple$S* tuple)
+{
+    MinipyText* text = minipy_text_begin();
+    minipy_text_append(text, "(", 1);
+
+    for (int i = 0; i < tuple->size; i++)
+    {
+        if (i > 0)
+            minipy_text_append(text, ", ", 2);
+
+        minipy_text_put_$S(text, tuple->data[i]);
+    }
+
+    if (tuple->size == 1)
+        minipy_text_append(text, ",", 1);
+
+    minipy_text_append(text, ")", 1);
+    return text->data;
+}
+)C";
+
+//Open-addressing index over entries kept in insertion order, shared by every dict specialization.
+//Slots hold entry index + 1, 0 = empty; the load factor stays at or below one half.
+const char* const RUNTIME_DICT_INDEX = R"C(
+static inline unsigned minipy_hash(String key)
+{
+    const char* data = string_data(key);
+    unsigned hash = 2166136261u;
+
+    for (int i = 0; i < key.length; i++)
+        hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+
+    return hash;
+}
+
+static inline unsigned minipy_slot(const int* slots, unsigned mask, const String* keys, const unsigned* hashes, String key, unsigned hash)
+{
+    unsigned slot = hash & mask;
+
+    while (slots[slot])
+    {
+        int entry = slots[slot] - 1;
+
+        if (hashes[entry] == hash && keys[entry].length == key.length && memcmp(string_data(keys[entry]), string_data(key), key.length) == 0)
+            break;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+static inline int* minipy_reindex(int* slots, unsigned* mask, const unsigned* hashes, int size)
+{
+    *mask = *mask * 2 + 1;
+    slots = (int*)realloc(slots, sizeof(int) * (*mask + 1));
+    memset(slots, 0, sizeof(int) * (*mask + 1));
+
+    for (int entry = 0; entry < size; entry++)
+    {
+        unsigned slot = hashes[entry] & *mask;
+
+        while (slots[slot])
+            slot = (slot + 1) & *mask;
+
+        slots[slot] = entry + 1;
+    }
+
+    return slots;
+}
+
+static inline void minipy_missing_key(String key)
+{
+    minipy_flush();
+    fprintf(stderr, "KeyError: '%.*s'\n", key.length, string_data(key));
+    exit(1);
+}
+)C";
+
+//Keys are copied on insert; keys and values are owned by the dict
+const char* const RUNTIME_DICT = R"C(
+typedef struct
+{
+    String* keys;
+    $T* values;
+    unsigned* hashes;
+    int* slots;
+    unsigned mask;
+    int size;
+    int capacity;
+} DictString$S;
+
+static inline DictString$S* create_dict_string_$S(void)
+{
+    DictString$S* dict = (DictString$S*)malloc(sizeof(DictString$S));
+    dict->size = 0;
+    dict->capacity = 8;
+    dict->mask = 15;
+    dict->keys = (String*)malloc(sizeof(String) * dict->capacity);
+    dict->values = ($T*)malloc(sizeof($T) * dict->capacity);
+    dict->hashes = (unsigned*)malloc(sizeof(unsigned) * dict->capacity);
+    dict->slots = (int*)calloc(dict->mask + 1, sizeof(int));
+    return dict;
+}
+
+static inline void dict_set_string_$S(DictString$S* dict, String key, $T value)
+{
+    unsigned hash = minipy_hash(key);
+    unsigned slot = minipy_slot(dict->slots, dict->mask, dict->keys, dict->hashes, key, hash);
+
+    if (dict->slots[slot])
+    {
+        $F(dict->values[dict->slots[slot] - 1]);
+        dict->values[dict->slots[slot] - 1] = value;
+        return;
+    }
+
+    if (dict->size == dict->capacity)
+    {
+        dict->capacity *= 2;
+        dict->keys = (String*)realloc(dict->keys, sizeof(String) * dict->capacity);
+        dict->values = ($T*)realloc(dict->values, sizeof($T) * dict->capacity);
+        dict->hashes = (unsigned*)realloc(dict->hashes, sizeof(unsigned) * dict->capacity);
+    }
+
+    dict->keys[dict->size] = string_copy(key);
+    dict->values[dict->size] = value;
+    dict->hashes[dict->size] = hash;
+    dict->slots[slot] = ++dict->size;
+
+    if ((unsigned)dict->size * 2 > dict->mask + 1)
+        dict->slots = minipy_reindex(dict->slots, &dict->mask, dict->hashes, dict->size);
+}
+
+static inline $T dict_get_string_$S(const DictString$S* dict, String key)
+{
+    unsigned slot = minipy_slot(dict->slots, dict->mask, dict->keys, dict->hashes, key, minipy_hash(key));
+
+    if (!dict->slots[slot])
+        minipy_missing_key(key);
+
+    return dict->values[dict->slots[slot] - 1];
+}
+
+static inline void free_dict_string_$S(DictString$S* dict)
+{
+    if (!dict)
+        return;
+
+    for (int i = 0; i < dict->size; i++)
+    {
+        free_string(dict->keys[i]);
+        $F(dict->values[i]);
+    }
+
+    free(dict->keys);
+    free(dict->values);
+    free(dict->hashes);
+    free(dict->slots);
+    free(dict);
+}
+
+static inline DictString$S* copy_dict_string_$S(const DictString$S* dict)
+{
+    DictString$S* copy = create_dict_string_$S();
+
+    for (int i = 0; i < dict->size; i++)
+        dict_set_string_$S(copy, dict->keys[i], $C(dict->values[i]));
+
+    return copy;
+}
+
+static inline DictString$S* move_dict_string_$S(DictString$S** dict)
+{
+    DictString$S* value = *dict;
+    *dict = NULL;
+    return value;
+}
+)C";
+
+const char* const RUNTIME_DICT_TO_STRING = R"C(
+static inline char* dict_to_string_string_$S(const DictString$S* dict)
+{
+    MinipyText* text = minipy_text_begin();
+    minipy_text_append(text, "{", 1);
+
+    for (int i = 0; i < dict->size; i++)
+    {
+        if (i > 0)
+            minipy_text_append(text, ", ", 2);
+
+        minipy_text_put_string(text, dict->keys[i]);
+        minipy_text_append(text, ": ", 2);
+        minipy_text_put_$S(text, dict->values[i]);
+    }
+
+    minipy_text_append(text, "}", 1);
+    return text->data;
+}
+)C";
+
+//String methods return new owned strings (str_find returns an index, -1 when absent)
+const char* const RUNTIME_STRING_SEARCH = R"C(
+static inline int minipy_find(String s, String sub, int from)
+{
+    const char* data = string_data(s);
+    const char* needle = string_data(sub);
+
+    if (sub.length == 0)
+        return from <= s.length ? from : -1;
+
+    for (int i = from; i + sub.length <= s.length; i++)
+    {
+        const char* p = (const char*)memchr(data + i, needle[0], s.length - sub.length - i + 1);
+
+        if (!p)
+            return -1;
+
+        i = (int)(p - data);
+
+        if (memcmp(p, needle, sub.length) == 0)
+            return i;
+    }
+
+    return -1;
+}
+)C";
+
+const char* const RUNTIME_IS_SPACE = R"C(
+static inline int minipy_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+)C";
+
+const char* const RUNTIME_STR_UPPER = R"C(
+static inline String str_upper(String s)
+{
+    String result = string_copy(s);
+    char* data = string_data(result);
+
+    for (int i = 0; i < result.length; i++)
+    {
+        if (data[i] >= 'a' && data[i] <= 'z')
+            data[i] -= 'a' - 'A';
+    }
+
+    return result;
+}
+)C";
+
+const char* const RUNTIME_STR_LOWER = R"C(
+static inline String str_lower(String s)
+{
+    String result = string_copy(s);
+    char* data = string_data(result);
+
+    for (int i = 0; i < result.length; i++)
+    {
+        if (data[i] >= 'A' && data[i] <= 'Z')
+            data[i] += 'a' - 'A';
+    }
+
+    return result;
+}
+)C";
+
+const char* const RUNTIME_STR_STRIP = R"C(
+static inline String str_strip(String s)
+{
+    const char* data = string_data(s);
+    int start = 0;
+    int end = s.length;
+
+    while (start < end && minipy_is_space(data[start]))
+        start++;
+
+    while (end > start && minipy_is_space(data[end - 1]))
+        end--;
+
+    return string_from(data + start, end - start);
+}
+)C";
+
+const char* const RUNTIME_STR_REPLACE = R"C(
+static inline String str_replace(String s, String old, String replacement)
+{
+    if (old.length == 0)
+        return string_copy(s);
+
+    const char* data = string_data(s);
+    String result = string_from(data, 0);
+    int start = 0;
+
+    for (int found = minipy_find(s, old, 0); found >= 0; found = minipy_find(s, old, start))
+    {
+        string_append(&result, string_borrow(data + start, found - start));
+        string_append(&result, replacement);
+        start = found + old.length;
+    }
+
+    string_append(&result, string_borrow(data + start, s.length - start));
+    return result;
+}
+)C";
+
+const char* const RUNTIME_STR_FIND = R"C(
+static inline int str_find(String s, String sub)
+{
+    return minipy_find(s, sub, 0);
+}
+)C";
+
+//Pieces are cut from one copy of the source, owned by the returned list, and borrow from it
+const char* const RUNTIME_SPLIT = R"C(
+static inline Liststring* minipy_split_list(String s, char** copy)
+{
+    Liststring* list = create_list_string(0);
+    list->storage = (char*)malloc(s.length + 1);
+    memcpy(list->storage, string_data(s), s.length);
+    list->storage[s.length] = '\0';
+    *copy = list->storage;
+    return list;
+}
+
+static inline Liststring* str_split_whitespace(String s)
+{
+    char* copy;
+    Liststring* list = minipy_split_list(s, &copy);
+    int i = 0;
+
+    while (i < s.length)
+    {
+        while (i < s.length && minipy_is_space(copy[i]))
+            i++;
+
+        if (i == s.length)
+            break;
+
+        int start = i;
+
+        while (i < s.length && !minipy_is_space(copy[i]))
+            i++;
+
+        list_append_string(list, string_borrow(copy + start, i - start));
+        copy[i++] = '\0';
+    }
+
+    return list;
+}
+
+static inline Liststring* str_split(String s, String separator)
+{
+    char* copy;
+    Liststring* list = minipy_split_list(s, &copy);
+    String source = string_borrow(copy, s.length);
+    int start = 0;
+
+    if (separator.length > 0)
+    {
+        for (int found = minipy_find(source, separator, 0); found >= 0; found = minipy_find(source, separator, start))
+        {
+            copy[found] = '\0';
+            list_append_string(list, string_borrow(copy + start, found - start));
+            start = found + separator.length;
+        }
+    }
+
+    list_append_string(list, string_borrow(copy + start, s.length - start));
+    return list;
+}
+)C";
+
+//print builds each line in its own buffer, one per nesting level since evaluating a value may itself
+//print, and then copies it into the output buffer
+const char* const RUNTIME_PRINT = R"C(
+static MinipyText** minipy_lines;
+static int minipy_line_count;
+static int minipy_print_depth;
+
+static inline MinipyText* minipy_print_begin(void)
+{
+    if (minipy_print_depth == minipy_line_count)
+    {
+        minipy_lines = (MinipyText**)realloc(minipy_lines, sizeof(MinipyText*) * (minipy_line_count + 1));
+        minipy_lines[minipy_line_count++] = (MinipyText*)calloc(1, sizeof(MinipyText));
+    }
+
+    MinipyText* line = minipy_lines[minipy_print_depth++];
+    line->size = 0;
+    minipy_text_reserve(line, 0);
+    return line;
+}
+
+static inline void minipy_print_end(MinipyText* line)
+{
+    minipy_text_append(line, "\n", 1);
+    minipy_write(line->data, line->size);
+    minipy_print_depth--;
+
+    if (minipy_output.line_buffered)
+        minipy_flush();
+}
+
+static inline void minipy_print_string(MinipyText* line, String value)
+{
+    minipy_text_append(line, string_data(value), value.length);
+}
+
+static inline void minipy_print_text(MinipyText* line, const char* text)
+{
+    minipy_text_append(line, text, (int)strlen(text));
+}
+)C";
+
+const char* const RUNTIME_PRINT_FLOAT = R"C(
+static inline void minipy_print_float(MinipyText* line, float value)
+{
+    minipy_text_reserve(line, MINIPY_FLOAT_SIZE);
+    line->size += minipy_format_float(line->data + line->size, value);
+    line->data[line->size] = '\0';
+}
+)C";
+
+inline const char* runtime_put(VarType type)
+{
+	switch (type)
+	{
+	case VarType::INT:
+		return RUNTIME_PUT_INT;
+	case VarType::FLOAT:
+		return RUNTIME_PUT_FLOAT;
+	case VarType::BOOL:
+		return RUNTIME_PUT_BOOL;
+	default:
+		return RUNTIME_PUT_STRING;
+	}
+}
+
+//Emits the runtime for exactly the features recorded, dependencies first. The common part, with the
+//output buffer main() flushes, is always present.
+inline string generate_runtime(const RuntimeFeatures& features)
+{
+	string code = RUNTIME_COMMON;
+	uint32_t printed = features.printed_lists | features.printed_tuples | features.printed_dicts;
+	uint32_t values = features.printed_values;
+	bool split = features.has_method(StringMethod::SPLIT);
+	bool format = features.has_method(StringMethod::FORMAT);
+
+	if (features.printed_dicts)
+		printed |= RuntimeFeatures::bit(VarType::STRING);		//Keys
+
+	bool format_float = format || (values & RuntimeFeatures::bit(VarType::FLOAT));
+
+	//Floats are formatted through the integer formatter
+	if (format_float || ((printed | values) & RuntimeFeatures::bit(VarType::INT)))
+		code += RUNTIME_FORMAT_INT;
+
+	if (format_float)
+		code += RUNTIME_FORMAT_FLOAT;
+
+	if (printed || values)
+	{
+		code += RUNTIME_TEXT;
+
+		//print shares the element writers for ints and bools; it writes strings and floats its own way
+		for (VarType type : RuntimeFeatures::types(printed | (values & (RuntimeFeatures::bit(VarType::INT) | RuntimeFeatures::bit(VarType::BOOL)))))
+			code += runtime_put(type);
+	}
+
+	if (values)
+		code += RUNTIME_PRINT;
+
+	if (values & RuntimeFeatures::bit(VarType::FLOAT))
+		code += RUNTIME_PRINT_FLOAT;
+
+	if (format || features.has_method(StringMethod::CONCAT) || features.has_method(StringMethod::REPLACE))
+		code += RUNTIME_STRING_CONCAT;
+
+	if (format)
+		code += RUNTIME_STRING_FORMAT;
+
+	if (features.has_method(StringMethod::EQUALS))
+		code += RUNTIME_STRING_EQUALS;
+
+	if (features.has_method(StringMethod::COMPARE))
+		code += RUNTIME_STRING_COMPARE;
+
+	if (split || features.has_method(StringMethod::REPLACE) || features.has_method(StringMethod::FIND))
+		code += RUNTIME_STRING_SEARCH;
+
+	if (split || features.has_method(StringMethod::STRIP))
+		code += RUNTIME_IS_SPACE;
+
+	const pair<StringMethod, const char*> string_methods[] =
+	{
+		{ StringMethod::UPPER, RUNTIME_STR_UPPER }, { StringMethod::LOWER, RUNTIME_STR_LOWER }, { StringMethod::STRIP, RUNTIME_STR_STRIP },
+		{ StringMethod::REPLACE, RUNTIME_STR_REPLACE }, { StringMethod::FIND, RUNTIME_STR_FIND }
+	};
+
+	for (const auto& method : string_methods)
+	{
+		if (features.has_method(method.first))
+			code += method.second;
+	}
+
+	for (VarType type : RuntimeFeatures::types(features.lists))
+	{
+		code += specialize(RUNTIME_LIST, type);
+
+		if (features.appended_lists & RuntimeFeatures::bit(type))
+			code += specialize(RUNTIME_LIST_APPEND, type);
+
+		if (features.printed_lists & RuntimeFeatures::bit(type))
+			code += specialize(RUNTIME_LIST_TO_STRING, type);
+	}
+
+	for (VarType type : RuntimeFeatures::types(features.tuples))
+	{
+		code += specialize(RUNTIME_TUPLE, type);
+
+		if (features.printed_tuples & RuntimeFeatures::bit(type))
+			code += specialize(RUNTIME_TUPLE_TO_STRING, type);
+	}
+
+	if (features.dicts)
+		code += RUNTIME_DICT_INDEX;
+
+	for (VarType type : RuntimeFeatures::types(features.dicts))
+	{
+		code += specialize(RUNTIME_DICT, type);
+
+		if (features.printed_dicts & RuntimeFeatures::bit(type))
+			code += specialize(RUNTIME_DICT_TO_STRING, type);
+	}
+
+	if (split)
+		code += RUNTIME_SPLIT;
+
+	return code;
+}
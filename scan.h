@@ -0,0 +1,284 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SCAN_TARGET_AVX2
+#else
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace std;
+
+//---SCANNING---
+//Byte-class scanners used by the lexer. Each returns the first position in [p, end)
+//that is not part of the run (or end), reading 16 / 32 bytes per step where supported.
+struct Scanner
+{
+	const char* name;
+	const char* (*blanks)(const char* p, const char* end);			//Spaces and tabs, not newlines
+	const char* (*identifier)(const char* p, const char* end);		//[A-Za-z0-9_]
+	const char* (*quote)(const char* p, const char* end);			//Up to the next '"'
+	const char* (*fstring_text)(const char* p, const char* end);	//Up to the next '"', '{', '}' or ':'
+};
+
+inline bool is_blank_char(char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r' && c != '\n');
+}
+
+inline bool is_identifier_char(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+inline bool is_fstring_stop(char c)
+{
+	return c == '"' || c == '{' || c == '}' || c == ':';
+}
+
+inline const char* scalar_blanks(const char* p, const char* end)
+{
+	while (p < end && is_blank_char(*p))
+		p++;
+
+	return p;
+}
+
+inline const char* scalar_identifier(const char* p, const char* end)
+{
+	while (p < end && is_identifier_char(*p))
+		p++;
+
+	return p;
+}
+
+inline const char* scalar_quote(const char* p, const char* end)
+{
+	const char* found = (const char*)memchr(p, '"', end - p);
+
+	return found ? found : end;
+}
+
+inline const char* scalar_fstring_text(const char* p, const char* end)
+{
+	while (p < end && !is_fstring_stop(*p))
+		p++;
+
+	return p;
+}
+
+#ifdef SCAN_X86
+inline int first_set(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+//Unsigned lo <= x <= hi per byte
+inline __m128i sse2_in_range(__m128i x, char lo, char hi)
+{
+	__m128i offset = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+
+	return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8((char)(hi - lo))), offset);
+}
+
+inline uint32_t sse2_blank_mask(__m128i x)
+{
+	__m128i blank = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), sse2_in_range(x, '\t', '\r'));
+	blank = _mm_andnot_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')), blank);
+
+	return (uint32_t)_mm_movemask_epi8(blank);
+}
+
+inline uint32_t sse2_identifier_mask(__m128i x)
+{
+	__m128i alpha = sse2_in_range(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+	__m128i digit = sse2_in_range(x, '0', '9');
+	__m128i underscore = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+
+	return (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), underscore));
+}
+
+inline uint32_t sse2_fstring_stop_mask(__m128i x)
+{
+	__m128i stop = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('"')), _mm_cmpeq_epi8(x, _mm_set1_epi8('{')));
+	stop = _mm_or_si128(stop, _mm_cmpeq_epi8(x, _mm_set1_epi8('}')));
+
+	return (uint32_t)_mm_movemask_epi8(_mm_or_si128(stop, _mm_cmpeq_epi8(x, _mm_set1_epi8(':'))));
+}
+
+inline const char* sse2_blanks(const char* p, const char* end)
+{
+	for (; end - p >= 16; p += 16)
+	{
+		uint32_t miss = ~sse2_blank_mask(_mm_loadu_si128((const __m128i*)p)) & 0xFFFF;
+
+		if (miss)
+			return p + first_set(miss);
+	}
+
+	return scalar_blanks(p, end);
+}
+
+inline const char* sse2_identifier(const char* p, const char* end)
+{
+	for (; end - p >= 16; p += 16)
+	{
+		uint32_t miss = ~sse2_identifier_mask(_mm_loadu_si128((const __m128i*)p)) & 0xFFFF;
+
+		if (miss)
+			return p + first_set(miss);
+	}
+
+	return scalar_identifier(p, end);
+}
+
+inline const char* sse2_quote(const char* p, const char* end)
+{
+	for (; end - p >= 16; p += 16)
+	{
+		uint32_t hit = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8('"')));
+
+		if (hit)
+			return p + first_set(hit);
+	}
+
+	return scalar_quote(p, end);
+}
+
+inline const char* sse2_fstring_text(const char* p, const char* end)
+{
+	for (; end - p >= 16; p += 16)
+	{
+		uint32_t hit = sse2_fstring_stop_mask(_mm_loadu_si128((const __m128i*)p));
+
+		if (hit)
+			return p + first_set(hit);
+	}
+
+	return scalar_fstring_text(p, end);
+}
+
+SCAN_TARGET_AVX2 inline __m256i avx2_in_range(__m256i x, char lo, char hi)
+{
+	__m256i offset = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+
+	return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8((char)(hi - lo))), offset);
+}
+
+SCAN_TARGET_AVX2 inline const char* avx2_blanks(const char* p, const char* end)
+{
+	for (; end - p >= 32; p += 32)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)p);
+		__m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), avx2_in_range(x, '\t', '\r'));
+		blank = _mm256_andnot_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')), blank);
+		uint32_t miss = ~(uint32_t)_mm256_movemask_epi8(blank);
+
+		if (miss)
+			return p + first_set(miss);
+	}
+
+	return sse2_blanks(p, end);
+}
+
+SCAN_TARGET_AVX2 inline const char* avx2_identifier(const char* p, const char* end)
+{
+	for (; end - p >= 32; p += 32)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)p);
+		__m256i alpha = avx2_in_range(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+		__m256i digit = avx2_in_range(x, '0', '9');
+		__m256i underscore = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'));
+		uint32_t miss = ~(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), underscore));
+
+		if (miss)
+			return p + first_set(miss);
+	}
+
+	return sse2_identifier(p, end);
+}
+
+SCAN_TARGET_AVX2 inline const char* avx2_quote(const char* p, const char* end)
+{
+	for (; end - p >= 32; p += 32)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)p);
+		uint32_t hit = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')));
+
+		if (hit)
+			return p + first_set(hit);
+	}
+
+	return sse2_quote(p, end);
+}
+
+SCAN_TARGET_AVX2 inline const char* avx2_fstring_text(const char* p, const char* end)
+{
+	for (; end - p >= 32; p += 32)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)p);
+		__m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('{')));
+		stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('}')));
+		uint32_t hit = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(stop, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(':'))));
+
+		if (hit)
+			return p + first_set(hit);
+	}
+
+	return sse2_fstring_text(p, end);
+}
+
+inline bool cpu_has_avx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+
+	bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+
+	return os_saves_ymm && (info[1] & (1 << 5));
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+//Picks the widest implementation the CPU supports; MINIPY_SCAN=scalar|sse2|avx2 overrides
+inline Scanner select_scanner()
+{
+	const char* forced = getenv("MINIPY_SCAN");
+	string_view choice = forced ? forced : "";
+
+#ifdef SCAN_X86
+	if ((choice.empty() || choice == "avx2") && cpu_has_avx2())
+		return{ "avx2", avx2_blanks, avx2_identifier, avx2_quote, avx2_fstring_text };
+
+	if (choice != "scalar")
+		return{ "sse2", sse2_blanks, sse2_identifier, sse2_quote, sse2_fstring_text };
+#endif
+
+	return{ "scalar", scalar_blanks, scalar_identifier, scalar_quote, scalar_fstring_text };
+}
+
+inline const Scanner& scanner()
+{
+	static const Scanner selected = select_scanner();
+
+	return selected;
+}
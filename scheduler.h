@@ -0,0 +1,237 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//---SCHEDULER---
+//Fixed pool of workers, each owning a task deque. A worker runs its own tasks newest-first and,
+//once it runs dry, steals the oldest task from another worker, so follow-up tasks spawned by a
+//long job spread across idle threads instead of queueing behind it.
+class WorkStealingPool
+{
+private:
+	struct Worker
+	{
+		deque<function<void()>> tasks;
+		mutex lock;
+	};
+
+	vector<unique_ptr<Worker>> workers;
+	vector<thread> threads;
+	mutex idle_lock;
+	condition_variable idle_signal;
+	condition_variable done_signal;
+	size_t queued;						//Tasks waiting in some deque; guarded by idle_lock
+	size_t pending;						//Tasks submitted and not yet finished; guarded by idle_lock
+	size_t next_worker;
+	bool stopping;
+	exception_ptr error;
+
+	static int& current_index()
+	{
+		static thread_local int index = -1;
+
+		return index;
+	}
+
+public:
+	WorkStealingPool(unsigned count) : queued(0), pending(0), next_worker(0), stopping(false)
+	{
+		count = count ? count : 1;
+
+		for (unsigned i = 0; i < count; ++i)
+			workers.push_back(make_unique<Worker>());
+
+		for (unsigned i = 0; i < count; ++i)
+			threads.emplace_back([this, i] { run(i); });
+	}
+
+	~WorkStealingPool()
+	{
+		{
+			lock_guard<mutex> guard(idle_lock);
+			stopping = true;
+		}
+
+		idle_signal.notify_all();
+
+		for (auto& worker : threads)
+			worker.join();
+	}
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	//From a worker the task goes onto that worker's own deque, otherwise round-robin
+	void submit(function<void()> task)
+	{
+		int index = current_index();
+
+		{
+			lock_guard<mutex> guard(idle_lock);
+
+			if (index < 0)
+				index = (int)(next_worker++ % workers.size());
+
+			queued++;
+			pending++;
+		}
+
+		{
+			lock_guard<mutex> guard(workers[index]->lock);
+			workers[index]->tasks.push_back(move(task));
+		}
+
+		idle_signal.notify_one();
+	}
+
+	//Blocks until every submitted task, including ones submitted by tasks, has finished
+	void wait()
+	{
+		unique_lock<mutex> guard(idle_lock);
+		done_signal.wait(guard, [this] { return pending == 0; });
+
+		if (error)
+		{
+			exception_ptr first = error;
+			error = nullptr;
+			rethrow_exception(first);
+		}
+	}
+
+private:
+	bool take(size_t index, function<void()>& task)
+	{
+		//Own deque, newest first
+		{
+			Worker& own = *workers[index];
+			lock_guard<mutex> guard(own.lock);
+
+			if (!own.tasks.empty())
+			{
+				task = move(own.tasks.back());
+				own.tasks.pop_back();
+
+				return true;
+			}
+		}
+
+		//Steal the oldest task from the next non-empty victim
+		for (size_t offset = 1; offset < workers.size(); ++offset)
+		{
+			Worker& victim = *workers[(index + offset) % workers.size()];
+			lock_guard<mutex> guard(victim.lock);
+
+			if (!victim.tasks.empty())
+			{
+				task = move(victim.tasks.front());
+				victim.tasks.pop_front();
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void run(size_t index)
+	{
+		current_index() = (int)index;
+
+		while (true)
+		{
+			function<void()> task;
+
+			if (take(index, task))
+			{
+				{
+					lock_guard<mutex> guard(idle_lock);
+					queued--;
+				}
+
+				try
+				{
+					task();
+				}
+				catch (...)
+				{
+					lock_guard<mutex> guard(idle_lock);
+
+					if (!error)
+						error = current_exception();
+				}
+
+				lock_guard<mutex> guard(idle_lock);
+
+				if (--pending == 0)
+					done_signal.notify_all();
+
+				continue;
+			}
+
+			unique_lock<mutex> guard(idle_lock);
+			idle_signal.wait(guard, [this] { return stopping || queued > 0; });
+
+			if (stopping && queued == 0)
+				return;
+		}
+	}
+};
+
+//Counting semaphore bounding how many jobs of one kind run at once
+class JobLimit
+{
+private:
+	mutex lock;
+	condition_variable released;
+	unsigned available;
+
+public:
+	JobLimit(unsigned count) : available(count ? count : 1) {}
+
+	void acquire()
+	{
+		unique_lock<mutex> guard(lock);
+		released.wait(guard, [this] { return available > 0; });
+		available--;
+	}
+
+	void release()
+	{
+		{
+			lock_guard<mutex> guard(lock);
+			available++;
+		}
+
+		released.notify_one();
+	}
+};
+
+//Holds one slot of a JobLimit for its lifetime, so the slot comes back even if the job throws
+class JobSlot
+{
+private:
+	JobLimit& limit;
+
+public:
+	JobSlot(JobLimit& l) : limit(l)
+	{
+		limit.acquire();
+	}
+
+	~JobSlot()
+	{
+		limit.release();
+	}
+
+	JobSlot(const JobSlot&) = delete;
+	JobSlot& operator=(const JobSlot&) = delete;
+};
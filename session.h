@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+#include "source.h"
+#include "arena.h"
+#include "symbols.h"
+
+using namespace std;
+
+//---SESSION---
+//State owned by one compilation: the mapped input, the arena holding its AST, and its interned names.
+//Everything is released together when the session goes out of scope.
+struct Session
+{
+	SourceFile source;
+	Arena arena;
+	SymbolTable symbols;
+
+	Session(const string& path) : source(path), symbols(arena) {}
+};
@@ -0,0 +1,150 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+//---SOURCE FILE---
+//Read-only view of an input file, memory-mapped where the platform allows it
+class SourceFile
+{
+private:
+	const char* data;
+	size_t size;
+	bool mapped;
+	bool opened;
+	string fallback;
+
+public:
+	SourceFile(const string& path) : data(nullptr), size(0), mapped(false), opened(false)
+	{
+		if (map_file(path))
+			return;
+
+		//Fall back to reading the whole file (pipes, special files)
+		ifstream file(path, ios::binary);
+
+		if (!file.is_open())
+			return;
+
+		fallback.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+		data = fallback.data();
+		size = fallback.size();
+		opened = true;
+	}
+
+	~SourceFile()
+	{
+		if (!mapped)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap((void*)data, size);
+#endif
+	}
+
+	SourceFile(const SourceFile&) = delete;
+	SourceFile& operator=(const SourceFile&) = delete;
+
+	bool is_open() const
+	{
+		return opened;
+	}
+
+	string_view text() const
+	{
+		return string_view(data, size);
+	}
+
+private:
+	bool map_file(const string& path)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size;
+
+		if (!GetFileSizeEx(file, &file_size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		//Empty files cannot be mapped but are valid input
+		if (file_size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			opened = true;
+
+			return true;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+		if (mapping)
+			CloseHandle(mapping);
+
+		CloseHandle(file);
+
+		if (!view)
+			return false;
+
+		size = (size_t)file_size.QuadPart;
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+
+		if (fd < 0)
+			return false;
+
+		struct stat info;
+
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+		{
+			close(fd);
+			return false;
+		}
+
+		//Empty files cannot be mapped but are valid input
+		if (info.st_size == 0)
+		{
+			close(fd);
+			opened = true;
+
+			return true;
+		}
+
+		void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		if (view == MAP_FAILED)
+			return false;
+
+		size = (size_t)info.st_size;
+		madvise(view, size, MADV_SEQUENTIAL);
+#endif
+
+		data = (const char*)view;
+		mapped = true;
+		opened = true;
+
+		return true;
+	}
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+using namespace std;
+
+//---SYMBOLS---
+//Interns identifier spellings into dense IDs (0, 1, 2, ...) so later stages can index arrays
+//instead of comparing strings. Spellings are copied once into the session arena.
+class SymbolTable
+{
+private:
+	Arena& arena;
+	vector<string_view> names;			//ID -> spelling
+	vector<uint32_t> hashes;			//ID -> hash, avoids rehashing on growth
+	vector<uint32_t> slots;				//Open addressing, linear probing; ID + 1, 0 = empty
+	uint32_t mask;
+
+public:
+	static const uint32_t NONE = UINT32_MAX;
+
+	SymbolTable(Arena& a) : arena(a), slots(256, 0), mask(255) {}
+
+	//Returns the ID for the spelling, assigning the next one on first sight
+	uint32_t intern(string_view name)
+	{
+		uint32_t hash = hash_name(name);
+		uint32_t slot = hash & mask;
+
+		while (slots[slot] != 0)
+		{
+			uint32_t id = slots[slot] - 1;
+
+			if (hashes[id] == hash && names[id] == name)
+				return id;
+
+			slot = (slot + 1) & mask;
+		}
+
+		uint32_t id = (uint32_t)names.size();
+
+		names.push_back(arena.copy_string(name));
+		hashes.push_back(hash);
+		slots[slot] = id + 1;
+
+		//Keep the load factor at or below one half
+		if (names.size() * 2 > slots.size())
+			grow();
+
+		return id;
+	}
+
+	//Returns the ID for the spelling, or NONE if it was never interned
+	uint32_t find(string_view name) const
+	{
+		uint32_t hash = hash_name(name);
+
+		for (uint32_t slot = hash & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+		{
+			uint32_t id = slots[slot] - 1;
+
+			if (hashes[id] == hash && names[id] == name)
+				return id;
+		}
+
+		return NONE;
+	}
+
+	string_view name(uint32_t id) const
+	{
+		return names[id];
+	}
+
+	size_t size() const
+	{
+		return names.size();
+	}
+
+private:
+	//FNV-1a
+	static uint32_t hash_name(string_view name)
+	{
+		uint32_t hash = 2166136261u;
+
+		for (char c : name)
+			hash = (hash ^ (uint8_t)c) * 16777619u;
+
+		return hash;
+	}
+
+	void grow()
+	{
+		slots.assign(slots.size() * 2, 0);
+		mask = (uint32_t)slots.size() - 1;
+
+		for (uint32_t id = 0; id < names.size(); ++id)
+		{
+			uint32_t slot = hashes[id] & mask;
+
+			while (slots[slot] != 0)
+				slot = (slot + 1) & mask;
+
+			slots[slot] = id + 1;
+		}
+	}
+};
@@ -0,0 +1,37 @@
+#!/bin/sh
+#Compiles every tests/*.minipy, runs it and compares its output with the matching .out file
+#Usage: tests/run_tests.sh <minipy>
+#Set CC to check generated code under sanitizers, e.g. CC="gcc -fsanitize=address,undefined"
+if [ $# -ne 1 ]; then
+	echo "Usage: $0 <minipy>" >&2
+	exit 2
+fi
+
+minipy=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+tests=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+failed=0
+
+cd "$work" || exit 2
+
+for source in "$tests"/*.minipy; do
+	name=$(basename "$source" .minipy)
+
+	if ! "$minipy" -o "$name" "$source" > /dev/null 2> "$name.err"; then
+		echo "FAIL $name: did not compile"
+		cat "$name.err"
+		failed=1
+	elif ! "./$name" > "$name.txt" 2> "$name.err" || [ -s "$name.err" ]; then
+		echo "FAIL $name: did not run cleanly"
+		cat "$name.err"
+		failed=1
+	elif ! diff -u "$tests/$name.out" "$name.txt"; then
+		echo "FAIL $name: wrong output"
+		failed=1
+	else
+		echo "ok   $name"
+	fi
+done
+
+exit $failed
@@ -0,0 +1,242 @@
+#pragma once
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//---TOOLCHAIN---
+//Host C compiler backends. Each turns a source file into an object, and a main file plus objects
+//into an executable, with the requested optimization settings.
+struct ToolchainOptions
+{
+	string compiler;					//Explicit compiler command; empty: $CC, then search PATH
+	int optimization = 0;				//0, 2 or 3
+	bool native_arch = false;
+	bool lto = false;
+};
+
+class Toolchain
+{
+protected:
+	string command;
+
+public:
+	Toolchain(const string& cmd) : command(cmd) {}
+	virtual ~Toolchain() {}
+
+	const string& compiler() const
+	{
+		return command;
+	}
+
+	virtual string object_extension() const = 0;
+	virtual string executable_extension() const = 0;
+	virtual string shared_library_extension() const = 0;
+
+	//Everything that affects generated objects, so cached objects are never mixed across settings
+	virtual string fingerprint() const = 0;
+
+	virtual string compile_command(const string& source, const string& object) const = 0;
+	virtual string link_command(const string& source, const vector<string>& objects, const string& executable) const = 0;
+
+	//Builds a loadable library from one self-contained source
+	virtual string shared_library_command(const string& source, const string& library) const = 0;
+};
+
+//cc, gcc and clang share a command line
+class GccToolchain : public Toolchain
+{
+private:
+	string flags;
+
+public:
+	GccToolchain(const string& cmd, const ToolchainOptions& options) : Toolchain(cmd)
+	{
+		flags = " -O" + to_string(options.optimization);
+
+		if (options.native_arch)
+			flags += " -march=native";
+
+		if (options.lto)
+			flags += " -flto";
+	}
+
+	string object_extension() const override
+	{
+		return ".o";
+	}
+
+	string executable_extension() const override
+	{
+		return "";
+	}
+
+	string shared_library_extension() const override
+	{
+		return ".so";
+	}
+
+	string fingerprint() const override
+	{
+		return command + flags;
+	}
+
+	string compile_command(const string& source, const string& object) const override
+	{
+		return command + flags + " -c \"" + source + "\" -o \"" + object + "\"";
+	}
+
+	//Flags are repeated at link time so -flto optimizes across the main file and every function object
+	string link_command(const string& source, const vector<string>& objects, const string& executable) const override
+	{
+		string link = command + flags + " \"" + source + "\"";
+
+		for (const auto& object : objects)
+			link += " \"" + object + "\"";
+
+		return link + " -o \"" + executable + "\"";
+	}
+
+	string shared_library_command(const string& source, const string& library) const override
+	{
+		return command + flags + " -shared -fPIC \"" + source + "\" -o \"" + library + "\"";
+	}
+};
+
+class MsvcToolchain : public Toolchain
+{
+private:
+	string flags;
+	string link_flags;
+
+public:
+	//cl has no -O3 or -march=native equivalent: /O2 is its highest level and the target is left to its default
+	MsvcToolchain(const string& cmd, const ToolchainOptions& options) : Toolchain(cmd)
+	{
+		flags = options.optimization == 0 ? " /nologo /Od" : " /nologo /O2";
+
+		if (options.lto)
+		{
+			flags += " /GL";
+			link_flags = " /link /LTCG";
+		}
+	}
+
+	string object_extension() const override
+	{
+		return ".obj";
+	}
+
+	string executable_extension() const override
+	{
+		return ".exe";
+	}
+
+	string shared_library_extension() const override
+	{
+		return ".dll";
+	}
+
+	string fingerprint() const override
+	{
+		return command + flags + link_flags;
+	}
+
+	string compile_command(const string& source, const string& object) const override
+	{
+		return command + flags + " /c \"" + source + "\" /Fo\"" + object + "\"";
+	}
+
+	string link_command(const string& source, const vector<string>& objects, const string& executable) const override
+	{
+		string link = command + flags + " \"" + source + "\"";
+
+		for (const auto& object : objects)
+			link += " \"" + object + "\"";
+
+		return link + " /Fe\"" + executable + "\"" + link_flags;
+	}
+
+	string shared_library_command(const string& source, const string& library) const override
+	{
+		return command + flags + " /LD \"" + source + "\" /Fe\"" + library + "\"" + link_flags;
+	}
+};
+
+//Returns the full path of an executable on PATH, or an empty string
+inline string find_program(const string& name)
+{
+#ifdef _WIN32
+	const char separator = ';';
+	const string suffix = ".exe";
+#else
+	const char separator = ':';
+	const string suffix = "";
+#endif
+
+	const char* path = getenv("PATH");
+
+	if (!path)
+		return "";
+
+	string directories = path;
+	size_t start = 0;
+
+	while (start <= directories.size())
+	{
+		size_t end = directories.find(separator, start);
+
+		if (end == string::npos)
+			end = directories.size();
+
+		filesystem::path candidate = filesystem::path(directories.substr(start, end - start)) / (name + suffix);
+		error_code error;
+
+		if (end > start && filesystem::is_regular_file(candidate, error))
+			return candidate.string();
+
+		start = end + 1;
+	}
+
+	return "";
+}
+
+//Picks the backend from the command's program name: cl is MSVC, anything else takes gcc flags
+inline unique_ptr<Toolchain> make_toolchain(const string& cmd, const ToolchainOptions& options)
+{
+	string program = cmd.substr(0, cmd.find(' '));
+
+	if (!program.empty() && program.front() == '"')
+		program = cmd.substr(1, cmd.find('"', 1) - 1);
+
+	if (filesystem::path(program).stem() == "cl")
+		return make_unique<MsvcToolchain>(cmd, options);
+
+	return make_unique<GccToolchain>(cmd, options);
+}
+
+//Explicit --cc, then $CC, then the first of cc, gcc, clang, cl found on PATH
+inline unique_ptr<Toolchain> find_toolchain(const ToolchainOptions& options)
+{
+	if (!options.compiler.empty())
+		return make_toolchain(options.compiler, options);
+
+	const char* env = getenv("CC");
+
+	if (env && *env)
+		return make_toolchain(env, options);
+
+	for (const char* name : { "cc", "gcc", "clang", "cl" })
+	{
+		string path = find_program(name);
+
+		if (!path.empty())
+			return make_toolchain("\"" + path + "\"", options);
+	}
+
+	throw runtime_error("No C Compiler Found, Set CC or Pass --cc");
+}